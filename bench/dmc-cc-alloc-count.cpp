@@ -0,0 +1,89 @@
+/**
+ *  @file   dmc-cc-alloc-count.cpp
+ *  @brief  LD_PRELOAD library counting the heap allocations of dmc-cc, for the harness.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Built by bld/mk-harness.sh. (Linux, glibc)
+ *    At exit of a process named dmc-cc*, "COUNT BYTES\n" is appended to $DMC_CC_ALLOC_LOG.
+ *    The counters are plain: dmc-cc allocates from one thread.
+ */
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+
+extern "C" {
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void  __libc_free(void*);
+extern char* program_invocation_short_name;
+}
+
+namespace {
+
+unsigned long long  s_count;
+unsigned long long  s_bytes;
+
+void add(std::size_t n) {
+    ++s_count;
+    s_bytes += n;
+}
+
+struct Report {
+    ~Report() {
+        char const* log = std::getenv("DMC_CC_ALLOC_LOG");
+        if (!log || !*log || std::strncmp(program_invocation_short_name, "dmc-cc", 6) != 0)
+            return;
+        std::FILE* fp = std::fopen(log, "a");
+        if (fp) {
+            std::fprintf(fp, "%llu %llu\n", s_count, s_bytes);
+            std::fclose(fp);
+        }
+    }
+} s_report;
+
+}   // namespace
+
+extern "C" {
+
+void* malloc(std::size_t n) {
+    add(n);
+    return __libc_malloc(n);
+}
+
+void* calloc(std::size_t n, std::size_t m) {
+    add(n * m);
+    return __libc_calloc(n, m);
+}
+
+void* realloc(void* p, std::size_t n) {
+    add(n);
+    return __libc_realloc(p, n);
+}
+
+void free(void* p) {
+    __libc_free(p);
+}
+
+void* memalign(std::size_t a, std::size_t n) {
+    add(n);
+    return __libc_memalign(a, n);
+}
+
+void* aligned_alloc(std::size_t a, std::size_t n) {
+    add(n);
+    return __libc_memalign(a, n);
+}
+
+int posix_memalign(void** p, std::size_t a, std::size_t n) {
+    add(n);
+    *p = __libc_memalign(a, n);
+    return *p ? 0 : ENOMEM;
+}
+
+}   // extern "C"
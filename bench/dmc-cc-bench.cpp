@@ -0,0 +1,266 @@
+/**
+ *  @file   dmc-cc-bench.cpp
+ *  @brief  Micro benchmarks of cmd_line_args and the gcc -> dmc translation.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Build and run by bld/mk-bench.sh. (Linux)
+ *    One JSON object per line:
+ *      {"bench":"conv","args":1000,"iters":300,"ns_per_op":...,"ns_per_arg":...}
+ *
+ *  usage> dmc-cc-bench [--quick] [NAME...]
+ */
+#define DMC_CC_NO_MAIN
+#include "../src/dmc-cc.cpp"
+
+#include <time.h>
+
+namespace {
+
+double now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+}
+
+/// argv made of strs. argv[0] is "dmc-cc".
+class ArgvBuf {
+public:
+    explicit ArgvBuf(vector<string> const& strs) : strs_(strs) {
+        strs_.insert(strs_.begin(), "dmc-cc");
+        for (size_t i = 0; i < strs_.size(); ++i)
+            argv_.push_back(&strs_[i][0]);
+        argv_.push_back(NULL);
+    }
+    int     argc() { return int(argv_.size() - 1); }
+    char**  argv() { return &argv_[0]; }
+
+private:
+    vector<string>  strs_;
+    vector<char*>   argv_;
+};
+
+/// Typical arguments of a CMake generated compile/link.
+void gen_args(size_t n, vector<string>& v) {
+    static char const* const fixed[] = {
+        "-O2", "-g", "-Wall", "-c", "--std=c++11", "-fexceptions", "-frtti", "-v", "-o", "out/obj/main.o",
+    };
+    char buf[128];
+    v.clear();
+    for (size_t i = 0; i < n; ++i) {
+        switch (i % 8) {
+        case 0: sprintf(buf, "-DDEFINE_%u=%u", unsigned(i), unsigned(i)); break;
+        case 1: sprintf(buf, "-I../include/dir_%u/sub", unsigned(i)); break;
+        case 2: sprintf(buf, "src/module_%u/file_%u.cpp", unsigned(i / 64), unsigned(i)); break;
+        case 3: sprintf(buf, "-llib%u", unsigned(i)); break;
+        case 4: sprintf(buf, "-L../lib/dir_%u", unsigned(i)); break;
+        case 5: sprintf(buf, "-UUNDEF_%u", unsigned(i)); break;
+        default: strcpy(buf, fixed[i % (sizeof fixed / sizeof fixed[0])]); break;
+        }
+        v.push_back(buf);
+    }
+}
+
+/// Response text of args, quoted as CMake writes it.
+string make_rsp_text(vector<string> const& args) {
+    string s;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (i % 4 == 0) {
+            s += '"';
+            s += args[i];
+            s += '"';
+        } else {
+            s += args[i];
+        }
+        s += (i % 16 == 15) ? '\n' : ' ';
+    }
+    return s;
+}
+
+}   // namespace
+
+
+class ProgramBench {
+public:
+    ProgramBench() : quick_(false), rsp_args_(0) {}
+
+    int main(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            if (strcmp(argv[i], "--quick") == 0)
+                quick_ = true;
+            else
+                only_.push_back(argv[i]);
+        }
+        static size_t const sizes[] = { 10, 100, 1000, 10000, 100000 };
+        for (size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k) {
+            size_t n = sizes[k];
+            if (quick_ && n > 10000)
+                break;
+            vector<string> args;
+            gen_args(n, args);
+            run("opt_match",   n, args, &ProgramBench::bench_opt_match);
+            run("tokenize",    n, args, &ProgramBench::bench_tokenize);
+            run("rsp_insert",  n, args, &ProgramBench::bench_rsp_insert);
+            run("rsp_replace", n, args, &ProgramBench::bench_rsp_replace);
+            run("fsl_to_bsl",  n, args, &ProgramBench::bench_fsl_to_bsl);
+            run("conv",        n, args, &ProgramBench::bench_conv);
+        }
+        return 0;
+    }
+
+private:
+    typedef size_t (ProgramBench::*bench_fn)(vector<string> const&);
+
+    /// Repeat fn until 0.2s (--quick: 0.02s) passed, and print the average.
+    void run(char const* name, size_t n, vector<string> const& args, bench_fn fn) {
+        if (!only_.empty() && !has_file(only_, name))
+            return;
+        double limit = quick_ ? 2e7 : 2e8;
+        size_t iters = 0;
+        size_t sink  = 0;
+        double t0    = now_ns();
+        double t     = 0;
+        do {
+            sink += (this->*fn)(args);
+            ++iters;
+            t = now_ns() - t0;
+        } while (t < limit);
+        printf("{\"bench\":\"%s\",\"args\":%u,\"iters\":%u,\"ns_per_op\":%.0f,\"ns_per_arg\":%.2f,\"check\":%u}\n"
+               , name, unsigned(n), unsigned(iters), t / iters, t / iters / n, unsigned(sink % 1000));
+        fflush(stdout);
+    }
+
+    static bool has_file(vector<string> const& v, char const* s) {
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (v[i] == s)
+                return true;
+        }
+        return false;
+    }
+
+    /// cmd_line_args: prepare_get and get_opt over each argument.
+    size_t bench_opt_match(vector<string> const& strs) {
+        ArgvBuf         a(strs);
+        cmd_line_args<> args(a.argc(), a.argv());
+        string          str;
+        bool            flag = false;
+        size_t          hits = 0;
+        while (args.has_arg()) {
+            if (args.prepare_get()) {
+                if (args.get_opt("-D", str, false)
+                 || args.get_opt("-U", str, false)
+                 || args.get_opt("-I", str, true)
+                 || args.get_opt("-L", str, true)
+                 || args.get_opt("-l", str, true)
+                 || args.get_opt("-o", str, true)
+                 || args.get_opt("--std", str, false)
+                 || args.get_opt("-fexceptions")
+                 || args.get_opt("-frtti")
+                 || args.get_opt("-Wall")
+                 || args.get_opt("-g")
+                 || args.get_opt("-c")
+                 || args.get_opt("-v", flag))
+                {
+                    ++hits;
+                }
+            }
+        }
+        return hits;
+    }
+
+    /// _detail::tokenize_args of the response text of the whole command line.
+    size_t bench_tokenize(vector<string> const& strs) {
+        if (rsp_args_ != strs.size()) {
+            rsp_args_ = strs.size();
+            rsp_text_ = make_rsp_text(strs);
+        }
+        size_t        len = rsp_text_.size();
+        vector<char>  dst(len + 1);
+        vector<char*> ptrs((len + 1) / 2 + 1);
+        return size_t(zatu::_detail::tokenize_args(rsp_text_.data(), rsp_text_.data() + len, &dst[0], &ptrs[0]));
+    }
+
+    /// insert_response_str of the whole command line.
+    size_t bench_rsp_insert(vector<string> const& strs) {
+        if (rsp_args_ != strs.size()) {
+            rsp_args_ = strs.size();
+            rsp_text_ = make_rsp_text(strs);
+        }
+        vector<string>  none;
+        ArgvBuf         a(none);
+        cmd_line_args<> args(a.argc(), a.argv());
+        args.insert_response_str(rsp_text_);
+        size_t n = 0;
+        while (args.has_arg()) {
+            args.prepare_get();
+            ++n;
+        }
+        return n;
+    }
+
+    /// @FILE arguments, each replaced by 10 arguments by replace_response_str.
+    size_t bench_rsp_replace(vector<string> const& strs) {
+        size_t files = (strs.size() + 9) / 10;
+        if (rsp_parts_.size() != files) {
+            rsp_parts_.clear();
+            for (size_t i = 0; i < files; ++i) {
+                size_t         b = i * 10;
+                size_t         e = (b + 10 < strs.size()) ? b + 10 : strs.size();
+                vector<string> part(strs.begin() + b, strs.begin() + e);
+                rsp_parts_.push_back(make_rsp_text(part));
+            }
+        }
+        vector<string> ats;
+        char           buf[32];
+        for (size_t i = 0; i < files; ++i) {
+            sprintf(buf, "@%u", unsigned(i));
+            ats.push_back(buf);
+        }
+        ArgvBuf         a(ats);
+        cmd_line_args<> args(a.argc(), a.argv());
+        size_t n = 0;
+        while (args.has_arg()) {
+            args.prepare_get();
+            char const* p = args.get_arg();
+            if (*p == '@')
+                args.replace_response_str(rsp_parts_[strz_to<unsigned>(p + 1)]);
+            else
+                ++n;
+        }
+        return n;
+    }
+
+    /// Program::str_fsl_to_bsl of each argument.
+    size_t bench_fsl_to_bsl(vector<string> const& strs) {
+        Program p;
+        size_t  n = 0;
+        for (size_t i = 0; i < strs.size(); ++i) {
+            string s = strs[i];
+            p.str_fsl_to_bsl(s);
+            n += s[s.size() - 1];
+        }
+        return n;
+    }
+
+    /// Program::conv_gcc_to_native_args of the whole command line.
+    size_t bench_conv(vector<string> const& strs) {
+        ArgvBuf a(strs);
+        Program p;
+        p.ccpath_ = "dmc-cc";
+        p.conv_gcc_to_native_args(a.argc(), a.argv());
+        return p.dst_args_.size();
+    }
+
+private:
+    bool            quick_;
+    vector<string>  only_;
+    size_t          rsp_args_;      // number of args of rsp_text_.
+    string          rsp_text_;
+    vector<string>  rsp_parts_;
+};
+
+
+int main(int argc, char* argv[]) {
+    return ProgramBench().main(argc, argv);
+}
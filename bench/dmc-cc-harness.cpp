@@ -0,0 +1,605 @@
+/**
+ *  @file   dmc-cc-harness.cpp
+ *  @brief  End to end overhead of dmc-cc: a generated project compiled by a stub dmc.exe.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Build and run by bld/mk-harness.sh. (Linux)
+ *    dmc-cc, dmc-cc-stub (as dmc.exe) and dmc-cc-alloc-count.so are taken from the
+ *    directory of the harness. The project is made in WORK: TUS sources including
+ *    8 of HEADERS headers in INCS -I directories (some written twice, one missing),
+ *    and DEFS -D options. Each TU is compiled as make -jJOBS does, once with the
+ *    options on the command line and once through @common.rsp, then linked.
+ *    One JSON object per line:
+ *      {"harness":"compile","mode":"cmdline","runs":..,"p50_us":..,"p99_us":..
+ *      ,"stub_p50_us":..,"stub_p99_us":..,"overhead_p50_us":..,"syscalls":..,"allocs":..,...}
+ *    stub_*: dmc-cc-stub run directly by the arguments dmc-cc gave it.
+ *    overhead_*: percentiles of the differences of each run and its stub run.
+ *    syscalls, allocs, alloc_bytes: of one dmc-cc process. (-1: not measured)
+ *    Then the arguments the stub got for a small fixed project are compared with
+ *    GOLDEN/MODE-NAME.argv, and the exit code is 1 if any differs. The golden check has
+ *    a third mode, longcmd: the command line of cmdline run by dmc-cc-cmdmax40 (built with
+ *    DMC_CC_CMDLINE_MAX=40), so that dmc gets everything by @RSP. The arguments the stub
+ *    reads in rsp and longcmd, with each @RSP expanded, must be the same as those of cmdline.
+ *    Last, --CC-watch is run with DMC_CC_SERVER set: {"harness":"watch-server","builds":..,"ok":..}
+ *    It must build, build again after a header changes, and still be running.
+ *
+ *  usage> dmc-cc-harness [--quick] [--tus N] [--headers N] [--incs N] [--defs N]
+ *                        [--jobs N] [--iters N] [--work DIR] [--golden DIR] [--update-golden]
+ */
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include "../src/proc_util.hpp"
+#include "../src/file_util.hpp"
+#include "../src/cmd_line_args.hpp"
+
+using namespace std;
+using namespace zatu;
+
+namespace {
+
+typedef vector<string>  Cmd;
+
+double now_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) * 1e6 + double(ts.tv_nsec) / 1e3;
+}
+
+double percentile(vector<double> v, unsigned pct) {
+    if (v.empty())
+        return 0;
+    sort(v.begin(), v.end());
+    size_t i = v.size() * pct / 100;
+    return v[i < v.size() ? i : v.size() - 1];
+}
+
+string num(size_t n) {
+    char buf[32];
+    sprintf(buf, "%u", unsigned(n));
+    return buf;
+}
+
+bool write_text(string const& path, string const& s) {
+    string dir = path.substr(0, path.rfind('/'));
+    return file_util::make_dirs(dir) && file_util::file_save_atomic(path.c_str(), s);
+}
+
+/// Name the stub gives the record of the compile writing out.
+string record_name(string const& out) {
+    string s = out;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '/' || s[i] == '\\' || s[i] == '.')
+            s[i] = '_';
+    }
+    return s;
+}
+
+/// Size of the generated project.
+struct Params {
+    size_t  tus;
+    size_t  headers;
+    size_t  incs;
+    size_t  defs;
+    Params(size_t t, size_t h, size_t i, size_t d) : tus(t), headers(h), incs(i), defs(d) {}
+};
+
+/// Commands of a generated project. argv[0] of each is ROOT/bin/dmc-cc. (longcmd: dmc-cc-cmdmax40)
+struct Project {
+    string          root;
+    vector<Cmd>     compiles[3];    // [0]: options on the command line, [1]: by @common.rsp, [2]: longcmd.
+    Cmd             links[3];
+    vector<string>  outs;           // -o of compiles.
+};
+
+char const* const   s_modes[3] = { "cmdline", "rsp", "longcmd" };
+
+/// Arguments of a record of the stub, with the ones of each @RSP in place of it.
+string flatten_record(string const& text) {
+    string s;
+    for (size_t b = 0, e; b < text.size(); b = e + 1) {
+        e = text.find('\n', b);
+        if (e == string::npos)
+            e = text.size();
+        if (text.compare(b, e - b, "@") == 0)
+            continue;
+        if (text[b] == '\t')
+            ++b;
+        s.append(text, b, e - b);
+        s += '\n';
+    }
+    return s;
+}
+
+}   // namespace
+
+
+class ProgramHarness {
+public:
+    ProgramHarness()
+        : params_(64, 256, 64, 256), jobs_(proc_util::cpu_count()), iters_(5)
+        , update_golden_(false), fails_(0) {}
+
+    int main(int argc, char* argv[]) {
+        string work = proc_util::temp_dir() + "dmc-cc-harness";
+        for (int i = 1; i < argc; ++i) {
+            string a = argv[i];
+            char const* v = (i + 1 < argc) ? argv[i + 1] : "";
+            if (a == "--quick") {
+                params_.tus = 16;
+                iters_      = 2;
+            } else if (a == "--update-golden") {
+                update_golden_ = true;
+            } else if (a == "--tus")     { params_.tus     = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--headers") { params_.headers = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--incs")    { params_.incs    = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--defs")    { params_.defs    = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--jobs")    { jobs_           = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--iters")   { iters_          = strtoul(v, NULL, 10); ++i;
+            } else if (a == "--work")    { work            = v; ++i;
+            } else if (a == "--golden")  { golden_         = v; ++i;
+            } else {
+                fprintf(stderr, "usage> dmc-cc-harness [--quick] [--tus N] [--headers N] [--incs N] [--defs N]\n"
+                                "                      [--jobs N] [--iters N] [--work DIR] [--golden DIR] [--update-golden]\n");
+                return 1;
+            }
+        }
+        if (params_.tus == 0 || params_.headers == 0 || params_.incs == 0 || jobs_ == 0 || iters_ == 0) {
+            fprintf(stderr, "dmc-cc-harness: bad size\n");
+            return 1;
+        }
+        string self = proc_util::self_path(argv[0]);
+        bindir_ = self.substr(0, self.rfind('/'));
+        work    = file_util::normalize_path(file_util::full_path(work), '/');
+        if (system(("rm -rf '" + work + "'").c_str()) != 0 || !file_util::make_dirs(work)) {
+            fprintf(stderr, "dmc-cc-harness: cannot make %s\n", work.c_str());
+            return 1;
+        }
+        static char const* const envs[] = {
+            "MAKEFLAGS", "DMC_CC_CACHE_DIR", "DMC_CC_TRACE", "DMC_CC_WORKERS", "DMC_CC_SERVER",
+            "DMC_CC_TOOLCHAIN", "DMC_CC_TOOLCHAINS", "DMC_CC_NO_PROBE_CACHE", "DMC_STUB_ARGV", "LD_PRELOAD",
+        };
+        for (size_t i = 0; i < sizeof envs / sizeof envs[0]; ++i)
+            unsetenv(envs[i]);
+
+        Project p;
+        if (!make_project(work + "/big", params_, p))
+            return 1;
+        for (int m = 0; m < 2; ++m)
+            measure(p, m);
+
+        int rc = check_golden(work + "/golden");
+        rc |= check_watch_server(work + "/watch");
+        return (rc || fails_) ? 1 : 0;
+    }
+
+private:
+    /// Write the sources, headers and response files of prm under root, and the commands.
+    bool make_project(string const& root, Params const& prm, Project& p) {
+        p.root = root;
+        string bin = root + "/bin";
+        if (!file_util::make_dirs(bin) || !file_util::make_dirs(root + "/obj") || !file_util::make_dirs(root + "/state")
+            || !file_util::file_copy((bindir_ + "/dmc-cc").c_str(), (bin + "/dmc-cc").c_str())
+            || !file_util::file_copy((bindir_ + "/dmc-cc-cmdmax40").c_str(), (bin + "/dmc-cc-cmdmax40").c_str())
+            || !file_util::file_copy((bindir_ + "/dmc-cc-stub").c_str(), (bin + "/dmc.exe").c_str())
+            || chmod((bin + "/dmc-cc").c_str(), 0755) != 0 || chmod((bin + "/dmc-cc-cmdmax40").c_str(), 0755) != 0
+            || chmod((bin + "/dmc.exe").c_str(), 0755) != 0)
+        {
+            fprintf(stderr, "dmc-cc-harness: cannot set up %s (build by bld/mk-harness.sh)\n", root.c_str());
+            return false;
+        }
+        for (size_t h = 0; h < prm.headers; ++h) {
+            string name = "h" + num(h);
+            if (!write_text(root + "/inc/d" + num(h % prm.incs) + "/" + name + ".h"
+                            , "#ifndef " + name + "_H\n#define " + name + "_H\nint " + name + "_v;\n#endif\n"))
+                return false;
+        }
+        Cmd opts;
+        for (size_t k = 0; k < prm.incs; ++k) {
+            opts.push_back("-Iinc/d" + num(k));
+            if (k % 4 == 3)
+                opts.push_back("-I./inc/d" + num(k) + "/");
+            if (k % 8 == 5)
+                opts.push_back("-I" + root + "/inc/d" + num(k));
+        }
+        opts.push_back("-Iinc/missing");
+        for (size_t d = 0; d < prm.defs; ++d)
+            opts.push_back((d % 16 == 7) ? "-DSTR_" + num(d) + "=\"a b\"" : "-DDEF_" + num(d) + "=" + num(d));
+        opts.push_back("-O2");
+        opts.push_back("-g");
+        opts.push_back("-Wall");
+        string rsp;
+        for (size_t i = 0; i < opts.size(); ++i) {
+            append_response_arg(rsp, opts[i].c_str());
+            rsp += (i % 8 == 7) ? '\n' : ' ';
+        }
+        if (!write_text(root + "/common.rsp", rsp + "\n"))
+            return false;
+
+        string cc = bin + "/dmc-cc";
+        string objs;
+        for (size_t n = 0; n < prm.tus; ++n) {
+            string src = "src/tu" + num(n) + ".c";
+            string obj = "obj/tu" + num(n) + ".obj";
+            string text;
+            for (size_t j = 0; j < 8; ++j)
+                text += "#include \"h" + num((n * 7 + j * 13) % prm.headers) + ".h\"\n";
+            text += "int tu" + num(n) + "(void) { return " + num(n) + "; }\n";
+            if (!write_text(root + "/" + src, text))
+                return false;
+            p.outs.push_back(obj);
+            objs += obj + "\n";
+            for (int m = 0; m < 3; ++m) {
+                Cmd c(1, (m == 2) ? cc + "-cmdmax40" : cc);
+                if (m != 1)
+                    c.insert(c.end(), opts.begin(), opts.end());
+                else
+                    c.push_back("@common.rsp");
+                c.push_back("-c");
+                c.push_back(src);
+                c.push_back("-o");
+                c.push_back(obj);
+                p.compiles[m].push_back(c);
+            }
+        }
+        if (!write_text(root + "/link.rsp", objs))
+            return false;
+        for (int m = 0; m < 3; ++m) {
+            Cmd& c = p.links[m];
+            c.push_back((m == 2) ? cc + "-cmdmax40" : cc);
+            if (m != 1) {
+                for (size_t n = 0; n < p.outs.size(); ++n)
+                    c.push_back(p.outs[n]);
+            } else {
+                c.push_back("@link.rsp");
+            }
+            c.push_back("-o");
+            c.push_back("app.exe");
+        }
+        return true;
+    }
+
+    /// Environment and cwd for the commands of p. record: directory for the stub, or "".
+    static bool enter(Project const& p, string const& record) {
+        setenv("DMC_CC_STATE_DIR", (p.root + "/state").c_str(), 1);
+        setenv("DMC_STUB_ROOT", p.root.c_str(), 1);
+        if (record.empty()) {
+            unsetenv("DMC_STUB_ARGV");
+        } else {
+            if (!file_util::make_dirs(record))
+                return false;
+            setenv("DMC_STUB_ARGV", record.c_str(), 1);
+        }
+        return file_util::set_cwd(p.root.c_str());
+    }
+
+    /** Run cmds, jobs at a time. The latency of each is appended to lat, in the order of cmds.
+     *  (0: could not be started) @return number of failures.
+     */
+    size_t run_batch(vector<Cmd> const& cmds, size_t jobs, vector<double>* lat) {
+        vector<proc_util::proc_t>   ps(jobs);
+        vector<double>              t0(jobs);
+        vector<size_t>              at(jobs);
+        vector<char const*>         argv;
+        size_t                      next = 0, running = 0, fails = 0;
+        size_t                      base = lat ? lat->size() : 0;
+        if (lat)
+            lat->resize(base + cmds.size(), 0.0);
+        while (next < cmds.size() || running) {
+            if (next < cmds.size() && running < jobs) {
+                size_t s = 0;
+                while (ps[s].running())
+                    ++s;
+                argv.clear();
+                for (size_t i = 0; i < cmds[next].size(); ++i)
+                    argv.push_back(cmds[next][i].c_str());
+                argv.push_back(NULL);
+                t0[s] = now_us();
+                at[s] = next;
+                if (proc_util::proc_start(&argv[0], "/dev/null", ps[s]))
+                    ++running;
+                else
+                    ++fails;
+                ++next;
+                continue;
+            }
+            int rc = 0;
+            int s  = proc_util::proc_wait_any(&ps[0], ps.size(), rc);
+            if (s < 0)
+                break;
+            if (lat)
+                (*lat)[base + at[s]] = now_us() - t0[s];
+            fails += rc != 0;
+            --running;
+        }
+        return fails;
+    }
+
+    /// Run the link cmd n times. OUT is removed before each, else dmc-cc skips the link as up to date.
+    size_t run_link(Cmd const& cmd, size_t n, vector<double>* lat) {
+        size_t fails = 0;
+        for (size_t i = 0; i < n; ++i) {
+            remove(cmd.back().c_str());
+            fails += run_batch(vector<Cmd>(1, cmd), 1, lat);
+        }
+        return fails;
+    }
+
+    /// Syscalls made by cmd itself (not its children), by ptrace. (-1: not available)
+    static long count_syscalls(Cmd const& cmd) {
+        vector<char const*> argv;
+        for (size_t i = 0; i < cmd.size(); ++i)
+            argv.push_back(cmd[i].c_str());
+        argv.push_back(NULL);
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0)
+                _exit(126);
+            freopen("/dev/null", "w", stdout);
+            freopen("/dev/null", "w", stderr);
+            raise(SIGSTOP);
+            execv(argv[0], (char* const*)&argv[0]);
+            _exit(127);
+        }
+        if (pid < 0)
+            return -1;
+        int  st    = 0;
+        long stops = 0;
+        bool first = true;
+        while (waitpid(pid, &st, 0) == pid) {
+            if (WIFEXITED(st) || WIFSIGNALED(st))
+                return (WIFEXITED(st) && WEXITSTATUS(st) == 126) ? -1 : stops / 2;
+            int sig = 0;
+            if (first) {
+                first = false;
+                ptrace(PTRACE_SETOPTIONS, pid, NULL, (void*)PTRACE_O_TRACESYSGOOD);
+            } else if (WSTOPSIG(st) == (SIGTRAP | 0x80)) {
+                ++stops;
+            } else if (WSTOPSIG(st) != SIGTRAP) {
+                sig = WSTOPSIG(st);
+            }
+            if (ptrace(PTRACE_SYSCALL, pid, NULL, (void*)(long)sig) != 0) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &st, 0);
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+    /// Average allocations of one run of cmds, by dmc-cc-alloc-count.so. (-1: not available)
+    void count_allocs(vector<Cmd> const& cmds, string const& log, double& count, double& bytes) {
+        count = bytes = -1;
+        string so = bindir_ + "/dmc-cc-alloc-count.so";
+        if (!file_util::file_copy(so.c_str(), (log + ".so").c_str()))
+            return;
+        remove(log.c_str());
+        setenv("LD_PRELOAD", (log + ".so").c_str(), 1);
+        setenv("DMC_CC_ALLOC_LOG", log.c_str(), 1);
+        run_batch(cmds, 1, NULL);
+        unsetenv("LD_PRELOAD");
+        unsetenv("DMC_CC_ALLOC_LOG");
+        FILE* fp = fopen(log.c_str(), "r");
+        if (!fp)
+            return;
+        unsigned long long c, b;
+        size_t             n = 0;
+        double             tc = 0, tb = 0;
+        while (fscanf(fp, "%llu %llu", &c, &b) == 2) {
+            tc += double(c);
+            tb += double(b);
+            ++n;
+        }
+        fclose(fp);
+        if (n) {
+            count = tc / n;
+            bytes = tb / n;
+        }
+    }
+
+    /// Commands running the stub by the arguments recorded in dir for outs.
+    vector<Cmd> stub_cmds(Project const& p, string const& dir, vector<string> const& outs) {
+        vector<Cmd> v;
+        for (size_t i = 0; i < outs.size(); ++i) {
+            string raw;
+            if (!file_util::file_read((dir + "/" + record_name(outs[i]) + ".raw").c_str(), raw)) {
+                fprintf(stderr, "dmc-cc-harness: no record of %s\n", outs[i].c_str());
+                ++fails_;
+                continue;
+            }
+            Cmd c(1, p.root + "/bin/dmc.exe");
+            for (size_t b = 0, e; (e = raw.find('\0', b)) != string::npos; b = e + 1)
+                c.push_back(raw.substr(b, e - b));
+            v.push_back(c);
+        }
+        return v;
+    }
+
+    /// Print the compile and link results of mode m.
+    void measure(Project const& p, int m) {
+        string record = p.root + "/argv-" + s_modes[m];
+            vector<Cmd> compiles;
+        for (size_t r = 0; r < iters_; ++r)
+            compiles.insert(compiles.end(), p.compiles[m].begin(), p.compiles[m].end());
+
+        // one run recording the arguments. it warms the state directory up as well.
+        if (!enter(p, record))
+            return;
+        fails_ += run_batch(p.compiles[m], jobs_, NULL);
+        fails_ += run_link(p.links[m], 1, NULL);
+        enter(p, "");
+
+        vector<double> cc_lat, cc_stub, ld_lat, ld_stub;
+        size_t fails = run_batch(compiles, jobs_, &cc_lat);
+        fails += run_link(p.links[m], iters_, &ld_lat);
+        vector<Cmd> sc = stub_cmds(p, record, p.outs);
+        vector<Cmd> sl = stub_cmds(p, record, vector<string>(1, "app.exe"));
+        vector<Cmd> stub_compiles;
+        for (size_t r = 0; r < iters_; ++r)
+            stub_compiles.insert(stub_compiles.end(), sc.begin(), sc.end());
+        fails += run_batch(stub_compiles, jobs_, &cc_stub);
+        if (!sl.empty())
+            fails += run_link(sl[0], iters_, &ld_stub);
+        fails_ += fails;
+
+        double cc_allocs, cc_bytes, ld_allocs, ld_bytes;
+        count_allocs(p.compiles[m], p.root + "/alloc-cc.log", cc_allocs, cc_bytes);
+        remove(p.links[m].back().c_str());
+        count_allocs(vector<Cmd>(1, p.links[m]), p.root + "/alloc-ld.log", ld_allocs, ld_bytes);
+        long cc_calls = count_syscalls(p.compiles[m][0]);
+        remove(p.links[m].back().c_str());
+        long ld_calls = count_syscalls(p.links[m]);
+        report("compile", m, cc_lat, cc_stub, cc_calls, cc_allocs, cc_bytes, fails);
+        report("link",    m, ld_lat, ld_stub, ld_calls, ld_allocs, ld_bytes, fails);
+    }
+
+    void report(char const* kind, int m, vector<double> const& lat, vector<double> const& stub
+                , long syscalls, double allocs, double bytes, size_t fails)
+    {
+        vector<double> over;
+        for (size_t i = 0; i < lat.size() && i < stub.size(); ++i) {
+            if (lat[i] > 0 && stub[i] > 0)
+                over.push_back(lat[i] - stub[i]);
+        }
+        double p50 = percentile(lat, 50), p99 = percentile(lat, 99);
+        double s50 = percentile(stub, 50), s99 = percentile(stub, 99);
+        printf("{\"harness\":\"%s\",\"mode\":\"%s\",\"tus\":%u,\"headers\":%u,\"incs\":%u,\"defs\":%u,\"jobs\":%u"
+               ",\"runs\":%u,\"p50_us\":%.0f,\"p99_us\":%.0f,\"stub_p50_us\":%.0f,\"stub_p99_us\":%.0f"
+               ",\"overhead_p50_us\":%.0f,\"overhead_p99_us\":%.0f,\"syscalls\":%ld,\"allocs\":%.0f,\"alloc_bytes\":%.0f"
+               ",\"fails\":%u}\n"
+               , kind, s_modes[m], unsigned(params_.tus), unsigned(params_.headers), unsigned(params_.incs)
+               , unsigned(params_.defs), unsigned(jobs_), unsigned(lat.size()), p50, p99, s50, s99
+               , percentile(over, 50), percentile(over, 99), syscalls, allocs, bytes, unsigned(fails));
+        fflush(stdout);
+    }
+
+    /// Record the arguments of a small fixed project and compare them with golden_. @return 1: differs.
+    int check_golden(string const& root) {
+        if (golden_.empty())
+            return 0;
+        Project p;
+        if (!make_project(root, Params(3, 16, 8, 16), p))
+            return 1;
+        vector<string> outs = p.outs;
+        outs.push_back("app.exe");
+        size_t         files = 0, diffs = 0;
+        vector<string> base(outs.size());   // flattened records of cmdline, for rsp and longcmd.
+        for (int m = 0; m < 3; ++m) {
+            string record = root + "/argv-" + s_modes[m];
+            if (!enter(p, record))
+                return 1;
+            fails_ += run_batch(p.compiles[m], 1, NULL);
+            fails_ += run_link(p.links[m], 1, NULL);
+            for (size_t i = 0; i < outs.size(); ++i) {
+                string name = record_name(outs[i]) + ".argv";
+                string gold = golden_ + "/" + s_modes[m] + "-" + name;
+                string got, want;
+                file_util::file_read((record + "/" + name).c_str(), got);
+                ++files;
+                if (m == 0) {
+                    base[i] = flatten_record(got);
+                } else if (flatten_record(got) != base[i]) {
+                    fprintf(stderr, "dmc-cc-harness: %s differs from the arguments of cmdline\n", (record + "/" + name).c_str());
+                    ++diffs;
+                }
+                if (update_golden_) {
+                    write_text(gold, got);
+                } else if (!file_util::file_read(gold.c_str(), want) || got != want) {
+                    fprintf(stderr, "dmc-cc-harness: %s differs from %s\n", (record + "/" + name).c_str(), gold.c_str());
+                    ++diffs;
+                }
+            }
+        }
+        printf("{\"harness\":\"golden\",\"files\":%u,\"diffs\":%u,\"updated\":%d}\n"
+               , unsigned(files), unsigned(diffs), int(update_golden_));
+        return diffs ? 1 : 0;
+    }
+
+    /// Occurrences of s in the file path.
+    static size_t count_in_file(string const& path, char const* s) {
+        string text;
+        size_t n = 0;
+        file_util::file_read(path.c_str(), text);
+        for (size_t i = 0; (i = text.find(s, i)) != string::npos; i += strlen(s))
+            ++n;
+        return n;
+    }
+
+    /// Wait at most ms for n occurrences of s in the file path.
+    static bool wait_in_file(string const& path, char const* s, size_t n, unsigned ms) {
+        for (unsigned t = 0; count_in_file(path, s) < n; t += 50) {
+            if (t >= ms)
+                return false;
+            usleep(50 * 1000);
+        }
+        return true;
+    }
+
+    /** --CC-watch with DMC_CC_SERVER: the translated state comes from the server.
+     *  The first build, and one more after a header changes, must be done by a living watch. @return 1: failed.
+     */
+    int check_watch_server(string const& root) {
+        Project p;
+        if (!make_project(root, Params(1, 4, 2, 2), p) || !enter(p, root + "/argv"))
+            return 1;
+        char addr[32];
+        sprintf(addr, "127.0.0.1:%u", 20000 + proc_util::get_pid() % 20000);
+        setenv("DMC_CC_SERVER", addr, 1);
+        string              cc = p.root + "/bin/dmc-cc", srv_log = root + "/server.log", log = root + "/watch.log";
+        proc_util::proc_t   srv, w;
+        char const*         sargv[] = { cc.c_str(), "--CC-server", NULL };
+        bool                ok = proc_util::proc_start(sargv, srv_log.c_str(), srv) && wait_in_file(srv_log, "server", 1, 5000);
+        Cmd                 c = p.compiles[0][0];
+        c.insert(c.begin() + 1, "--CC-watch");
+        vector<char const*> argv;
+        for (size_t i = 0; i < c.size(); ++i)
+            argv.push_back(c[i].c_str());
+        argv.push_back(NULL);
+        ok = ok && proc_util::proc_start(&argv[0], log.c_str(), w) && wait_in_file(log, "done.", 1, 10000);
+        ok = ok && write_text(root + "/inc/d0/h0.h", "int h0_v, h0_w;\n") && wait_in_file(log, "done.", 2, 10000);
+        int rc = 0;
+        ok = ok && !proc_util::proc_try_wait(w, rc);
+        if (w.running()) {
+            kill(w.pid, SIGTERM);
+            proc_util::proc_wait(w);
+        }
+        Cmd stop(1, cc);
+        stop.push_back("--CC-server-stop");
+        run_batch(vector<Cmd>(1, stop), 1, NULL);
+        for (int t = 0; t < 40 && !proc_util::proc_try_wait(srv, rc); ++t)
+            usleep(50 * 1000);
+        if (srv.running()) {
+            kill(srv.pid, SIGTERM);
+            proc_util::proc_wait(srv);
+        }
+        unsetenv("DMC_CC_SERVER");
+        printf("{\"harness\":\"watch-server\",\"builds\":%u,\"ok\":%d}\n", unsigned(count_in_file(log, "done.")), int(ok));
+        if (!ok)
+            fprintf(stderr, "dmc-cc-harness: --CC-watch through the server failed. (see %s)\n", log.c_str());
+        return ok ? 0 : 1;
+    }
+
+private:
+    Params      params_;
+    size_t      jobs_;
+    size_t      iters_;
+    string      bindir_;
+    string      golden_;
+    bool        update_golden_;
+    size_t      fails_;
+};
+
+
+int main(int argc, char* argv[]) {
+    return ProgramHarness().main(argc, argv);
+}
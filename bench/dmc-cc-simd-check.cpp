@@ -0,0 +1,227 @@
+/**
+ *  @file   dmc-cc-simd-check.cpp
+ *  @brief  Randomized check that the SSE2, AVX2 and plain builds of cmd_line_args split text alike.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Built with -msse2, -mavx2 and -DZATU_NO_SIMD by bld/mk-bench.sh, which compares their outputs.
+ *    For each random case, prints its number and a hash of what span_plain (each mode, from
+ *    several starts), _detail::tokenize_args (to char and wchar_t) and replace_response_str
+ *    of @N arguments return. The text sits at a random alignment between random bytes.
+ *
+ *  usage> dmc-cc-simd-check [--cases N] [--seed S] [--dump CASE] [--mode]
+ */
+#include "../src/cmd_line_args.hpp"
+#include "../src/hash_util.hpp"
+#include <vector>
+
+using namespace std;
+using namespace zatu;
+
+namespace {
+
+/// xorshift64*. The same sequence in every build.
+class Rand {
+public:
+    explicit Rand(unsigned long long seed) : s_(seed * 2 + 1) {}
+    unsigned long long next() {
+        s_ ^= s_ >> 12;
+        s_ ^= s_ << 25;
+        s_ ^= s_ >> 27;
+        return s_ * 0x2545F4914F6CDD1DULL;
+    }
+    unsigned below(unsigned n) { return unsigned(next() >> 33) % n; }
+
+private:
+    unsigned long long  s_;
+};
+
+inline unsigned long long code(char c) { return (unsigned char)c; }
+inline unsigned long long code(wchar_t c) { return (unsigned long long)c; }
+
+/// Hash of the results, and their text with --dump.
+class Sink {
+public:
+    explicit Sink(FILE* dump) : dump_(dump) {}
+
+    void put(char const* tag, unsigned long long v) {
+        h_.add(tag).add_u64(v);
+        if (dump_)
+            fprintf(dump_, "%s %llu\n", tag, v);
+    }
+    template<typename C> void put_str(char const* tag, C const* s) {
+        h_.add(tag);
+        if (dump_)
+            fprintf(dump_, "%s \"", tag);
+        for (; *s; ++s) {
+            unsigned long long c = code(*s);
+            h_.add_u64(c);
+            if (dump_ && c >= 0x20 && c < 0x7f && c != '\\' && c != '"')
+                fprintf(dump_, "%c", int(c));
+            else if (dump_)
+                fprintf(dump_, "\\x%02llx", c);
+        }
+        h_.add_u64(~0ULL);
+        if (dump_)
+            fprintf(dump_, "\"\n");
+    }
+    string hex() { return h_.hex(); }
+
+private:
+    hash_util::fnv1a64  h_;
+    FILE*               dump_;
+};
+
+/// Random response text, heavy in the chars the tokenizer decides on.
+string gen_text(Rand& r, unsigned parts) {
+    static char const plain[] = "abcdefgxyzABCXYZ0123456789-_./\\=:+,";
+    unsigned len = r.below(8) ? r.below(80) : r.below(400);
+    string   s;
+    for (unsigned i = 0; i < len; ++i) {
+        unsigned k = r.below(100);
+        if (k < 55)       s += plain[r.below(sizeof plain - 1)];
+        else if (k < 67)  s += ' ';
+        else if (k < 75)  s += '"';
+        else if (k < 79)  s += '\n';
+        else if (k < 82)  s += (r.below(2) ? '\t' : '\r');
+        else if (k < 86)  s += '#';
+        else if (k < 88)  s += '\0';
+        else if (k < 89)  s += '\x7f';
+        else if (k < 91)  s += char(1 + r.below(0x1f));
+        else if (k < 96)  s += char(0x80 + r.below(0x80));
+        else if (parts) { s += " @"; s += char('0' + r.below(parts)); s += ' '; }
+        else              s += '@';
+    }
+    return s;
+}
+
+template<int M> void check_span(Sink& sk, Rand& r, char const* b, char const* e) {
+    size_t len = size_t(e - b);
+    for (unsigned i = 0; i < 12; ++i) {
+        char const* s = b + (i == 0 ? 0 : r.below(unsigned(len) + 1));
+        sk.put("span", (unsigned long long)(_detail::span_plain<M, char>(s, e) - b));
+    }
+}
+
+template<typename C> void check_tokenize(Sink& sk, char const* b, char const* e) {
+    size_t     len = size_t(e - b);
+    vector<C>  dst(len + 1);
+    vector<C*> args((len + 1) / 2 + 1);
+    int        num = _detail::tokenize_args(b, e, &dst[0], &args[0]);
+    sk.put("num", (unsigned long long)num);
+    for (int i = 0; i < num; ++i)
+        sk.put_str("arg", args[i]);
+}
+
+/// "@N" with N < parts: the index of a response part, or -1.
+int part_no(char const* p, unsigned parts) {
+    if (*p != '@' || !p[1])
+        return -1;
+    unsigned n = 0;
+    for (++p; *p; ++p) {
+        if (*p < '0' || *p > '9' || n > parts)
+            return -1;
+        n = n * 10 + unsigned(*p - '0');
+    }
+    return n < parts ? int(n) : -1;
+}
+
+/// argv of plain args and @N, each @N replaced by parts[N]. (at most 16 times, as parts may refer to each other)
+void check_splice(Sink& sk, Rand& r) {
+    unsigned       parts = 1 + r.below(4);
+    vector<string> texts;
+    for (unsigned i = 0; i < parts; ++i)
+        texts.push_back(gen_text(r, parts));
+    vector<string> strs(1, string("dmc-cc"));
+    for (unsigned i = 0, n = 1 + r.below(6); i < n; ++i) {
+        if (r.below(2)) {
+            strs.push_back("@0");
+            strs.back()[1] = char('0' + r.below(parts));
+        } else {
+            strs.push_back(r.below(2) ? "-O2" : "src/a.c");
+        }
+    }
+    vector<char*> argv;
+    for (size_t i = 0; i < strs.size(); ++i)
+        argv.push_back(&strs[i][0]);
+    argv.push_back(NULL);
+    cmd_line_args<> args(int(argv.size() - 1), &argv[0]);
+    unsigned        expands = 0;
+    while (args.has_arg()) {
+        args.prepare_get();
+        char const* p = args.get_arg();
+        int         n = part_no(p, parts);
+        if (n >= 0 && expands < 16) {
+            ++expands;
+            bool ok = (r.below(2) ? args.replace_response_str(texts[n])
+                                  : args.replace_response_str(texts[n].data(), texts[n].data() + texts[n].size(), "rsp"));
+            sk.put("replace", ok);
+        } else {
+            sk.put_str("got", p);
+        }
+    }
+    sk.put("argc", (unsigned long long)args.argc());
+}
+
+void check_case(Sink& sk, Rand& r) {
+    string      text = gen_text(r, 0);
+    unsigned    pad  = r.below(32);
+    vector<char> buf(pad + text.size() + 64);
+    for (size_t i = 0; i < buf.size(); ++i)
+        buf[i] = char(r.below(256));
+    if (!text.empty())
+        memcpy(&buf[pad], text.data(), text.size());
+    char const* b = &buf[pad];
+    char const* e = b + text.size();
+    check_span<_detail::SPAN_ARG>(sk, r, b, e);
+    check_span<_detail::SPAN_DQ >(sk, r, b, e);
+    check_span<_detail::SPAN_CMT>(sk, r, b, e);
+    check_tokenize<char>(sk, b, e);
+ #if !defined(ZATU_UNUSE_WCHAR_T)
+    check_tokenize<wchar_t>(sk, b, e);
+ #endif
+    check_splice(sk, r);
+}
+
+char const* simd_mode() {
+ #if defined(ZATU_CMDLINEARGS_AVX2)
+    return "avx2";
+ #elif defined(ZATU_CMDLINEARGS_SSE2)
+    return "sse2";
+ #else
+    return "none";
+ #endif
+}
+
+}   // namespace
+
+
+int main(int argc, char* argv[]) {
+    unsigned long long seed  = 1;
+    unsigned           cases = 20000;
+    long               dump  = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--mode") == 0) {
+            printf("%s\n", simd_mode());
+            return 0;
+        } else if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc) {
+            cases = strz_to<unsigned>(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strz_to<unsigned long long>(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            dump = strz_to<long>(argv[++i]);
+        } else {
+            fprintf(stderr, "usage> dmc-cc-simd-check [--cases N] [--seed S] [--dump CASE] [--mode]\n");
+            return 1;
+        }
+    }
+    for (unsigned c = 0; c < cases; ++c) {
+        Rand r(seed * 1000003ULL + c);
+        Sink sk(long(c) == dump ? stdout : NULL);
+        check_case(sk, r);
+        if (dump < 0)
+            printf("%u %s\n", c, sk.hex().c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ *  @file   dmc-cc-stub.cpp
+ *  @brief  dmc.exe stand-in for the harness: record argv, create the -o file and exit.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    DMC_STUB_ARGV=DIR  write DIR/NAME.argv: one argument per line, DMC_STUB_ROOT
+ *                       (either separator) replaced by "$ROOT". An @RSP is written "@",
+ *                       then the arguments cmd_line_args reads from it, each indented
+ *                       by a tab. (the name of RSP is a hash) And DIR/NAME.raw: the
+ *                       arguments '\0' separated, to run the stub again by them.
+ *                       NAME is the -o file with '/', '\\' and '.' made '_'. ("-" without -o)
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define ZATU_UNUSE_WCHAR_T
+#include "../src/cmd_line_args.hpp"
+
+namespace {
+
+void replace_all(std::string& s, std::string const& from, std::string const& to) {
+    if (from.empty())
+        return;
+    for (std::size_t p = s.find(from); p != std::string::npos; p = s.find(from, p + to.size()))
+        s.replace(p, from.size(), to);
+}
+
+std::string normalize(char const* arg, std::string const& root, std::string const& root_bsl) {
+    std::string s = arg;
+    replace_all(s, root, "$ROOT");
+    replace_all(s, root_bsl, "$ROOT");
+    return s;
+}
+
+bool read_file(std::string const& path, std::string& s) {
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+    char        buf[0x1000];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof buf, fp)) > 0)
+        s.append(buf, n);
+    std::fclose(fp);
+    return true;
+}
+
+void write_file(std::string const& path, std::string const& s) {
+    std::FILE* fp = std::fopen(path.c_str(), "wb");
+    if (fp) {
+        std::fwrite(s.data(), 1, s.size(), fp);
+        std::fclose(fp);
+    }
+}
+
+/// The arguments, with the ones cmd_line_args reads from each @RSP after it, marked by a tab.
+void expand_args(int argc, char* argv[], std::vector<std::string>& v) {
+    for (int i = 1; i < argc; ++i) {
+        v.push_back(argv[i]);
+        if (argv[i][0] != '@')
+            continue;
+        std::string path = argv[i] + 1, rsp;
+        for (std::size_t k = 0; k < path.size(); ++k) {
+            if (path[k] == '\\')
+                path[k] = '/';
+        }
+        if (!read_file(path, rsp))
+            continue;
+        zatu::cmd_line_args<> args(1, argv);
+        args.insert_response_str(rsp);
+        while (args.has_arg()) {
+            args.prepare_get();
+            v.push_back(std::string("\t") + args.get_arg_0());
+        }
+    }
+}
+
+}   // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    expand_args(argc, argv, args);
+    char const* out = NULL;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        char const* a = args[i].c_str() + (args[i][0] == '\t');
+        if (a[0] == '-' && a[1] == 'o' && a[2] && a[2] != '+' && a[2] != '-')
+            out = a + 2;
+    }
+    char const* dir = std::getenv("DMC_STUB_ARGV");
+    if (dir && *dir) {
+        char const* r        = std::getenv("DMC_STUB_ROOT");
+        std::string root     = r ? r : "";
+        std::string root_bsl = root;
+        for (std::size_t i = 0; i < root_bsl.size(); ++i) {
+            if (root_bsl[i] == '/')
+                root_bsl[i] = '\\';
+        }
+        std::string text, raw;
+        for (int i = 1; i < argc; ++i)
+            raw.append(argv[i], std::strlen(argv[i]) + 1);
+        for (std::size_t i = 0; i < args.size(); ++i)
+            text += (args[i][0] == '@') ? std::string("@\n") : normalize(args[i].c_str(), root, root_bsl) + "\n";
+        std::string name = out ? out : "-";
+        for (std::size_t i = 0; i < name.size(); ++i) {
+            if (name[i] == '/' || name[i] == '\\' || name[i] == '.')
+                name[i] = '_';
+        }
+        write_file(std::string(dir) + "/" + name + ".argv", text);
+        write_file(std::string(dir) + "/" + name + ".raw", raw);
+    }
+    if (out)
+        write_file(out, std::string());
+    return 0;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Build and run the micro benchmarks, after checking that the SSE2, AVX2 and plain builds of cmd_line_args agree. (Linux)
+#   sh bld/mk-bench.sh [--quick] [NAME...]  > result.jsonl
+cd "$(dirname "$0")/.." || exit 1
+mkdir -p bin
+CXX=${CXX:-g++}
+CASES=20000
+for a in "$@"; do
+    [ "$a" = "--quick" ] && CASES=2000
+done
+$CXX -std=c++98 -O2 -DNDEBUG -DZATU_NO_SIMD -o bin/dmc-cc-simd-none bench/dmc-cc-simd-check.cpp || exit 1
+$CXX -std=c++98 -O2 -DNDEBUG -msse2 -o bin/dmc-cc-simd-sse2 bench/dmc-cc-simd-check.cpp || exit 1
+$CXX -std=c++98 -O2 -DNDEBUG -mavx2 -o bin/dmc-cc-simd-avx2 bench/dmc-cc-simd-check.cpp || exit 1
+bin/dmc-cc-simd-none --cases $CASES > bin/simd-none.txt || exit 1
+for m in sse2 avx2; do
+    if [ "$(bin/dmc-cc-simd-$m --mode)" != $m ]; then
+        echo "dmc-cc-simd-$m: not built with $m" >&2
+        exit 1
+    fi
+    if [ $m = avx2 ] && ! grep -qw avx2 /proc/cpuinfo; then
+        echo "{\"check\":\"simd\",\"mode\":\"$m\",\"cases\":0,\"skipped\":1}"
+        continue
+    fi
+    bin/dmc-cc-simd-$m --cases $CASES > bin/simd-$m.txt || exit 1
+    if ! cmp -s bin/simd-none.txt bin/simd-$m.txt; then
+        c=$(diff bin/simd-none.txt bin/simd-$m.txt | sed -n 's/^> \([0-9]*\) .*/\1/p' | head -1)
+        echo "{\"check\":\"simd\",\"mode\":\"$m\",\"cases\":$CASES,\"ok\":0,\"first\":$c}"
+        echo "dmc-cc-simd-$m differs from dmc-cc-simd-none. (see: bin/dmc-cc-simd-$m --dump $c)" >&2
+        exit 1
+    fi
+    echo "{\"check\":\"simd\",\"mode\":\"$m\",\"cases\":$CASES,\"ok\":1}"
+done
+$CXX -std=c++98 -O2 -DNDEBUG -o bin/dmc-cc-bench bench/dmc-cc-bench.cpp || exit 1
+exec bin/dmc-cc-bench "$@"
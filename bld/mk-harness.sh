@@ -0,0 +1,12 @@
+#!/bin/sh
+# Build dmc-cc (and one passing everything by @RSP), the stub dmc.exe and the allocation counter, and run the end to end harness. (Linux)
+#   sh bld/mk-harness.sh [--quick] [--update-golden] [HARNESS-OPTIONS...]  > result.jsonl
+cd "$(dirname "$0")/.." || exit 1
+mkdir -p bin
+CXX=${CXX:-g++}
+$CXX -std=c++98 -O2 -DNDEBUG -o bin/dmc-cc src/dmc-cc.cpp || exit 1
+$CXX -std=c++98 -O2 -DNDEBUG -DDMC_CC_CMDLINE_MAX=40 -o bin/dmc-cc-cmdmax40 src/dmc-cc.cpp || exit 1
+$CXX -std=c++98 -O2 -o bin/dmc-cc-stub bench/dmc-cc-stub.cpp || exit 1
+$CXX -std=c++98 -O2 -shared -fPIC -o bin/dmc-cc-alloc-count.so bench/dmc-cc-alloc-count.cpp || exit 1
+$CXX -std=c++98 -O2 -o bin/dmc-cc-harness bench/dmc-cc-harness.cpp || exit 1
+exec bin/dmc-cc-harness --golden "$PWD/bench/golden" "$@"
@@ -3,7 +3,8 @@ pushd %~dp0
 
 if "%DMC%"=="" set DMC=c:\dmc
 
-dmc -I%DMC%\stlport\stlport -DNDEBUG -o+space -o..\bin\dmc-cc.exe ..\src\dmc-cc.cpp
+dmc -I%DMC%\stlport\stlport -DNDEBUG -o+space -o..\bin\dmc-cc.exe ..\src\dmc-cc.cpp ws2_32.lib advapi32.lib
+copy /y ..\bin\dmc-cc.exe ..\bin\dmc-ar.exe
 
 del *.bak *.obj *.map
 
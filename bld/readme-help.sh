@@ -0,0 +1,28 @@
+#!/bin/sh
+# Check that the usage block of README.md is the output of `dmc-cc --help`. (Linux)
+#   sh bld/readme-help.sh [--update]
+#   exit 1 if they differ. --update rewrites the block instead.
+cd "$(dirname "$0")/.." || exit 1
+mkdir -p bin
+${CXX:-g++} -std=c++98 -O2 -DNDEBUG -o bin/dmc-cc src/dmc-cc.cpp || exit 1
+bin/dmc-cc --help 2>/dev/null | sed 's/^usage> dmc-cc /usage> dmc-cc.exe /' > bin/help.txt
+
+# The fenced block after the line naming `dmc-cc.exe --help`: check prints it,
+# --update prints README.md with it replaced by help.txt.
+awk -v help=bin/help.txt -v update="$1" '
+    state == 0 && /`dmc-cc.exe --help`/ { state = 1 }
+    state == 2 && /^```/ { state = 3 }
+    state == 2 { if (update != "--update") print; next }
+    update == "--update" { print }
+    state == 1 && /^```/ {
+        state = 2
+        while (update == "--update" && (getline line < help) > 0)
+            print line
+    }
+' README.md > bin/readme-help.txt
+
+if [ "$1" = "--update" ]; then
+    cmp -s bin/readme-help.txt README.md || cp bin/readme-help.txt README.md
+    exit 0
+fi
+diff -u bin/readme-help.txt bin/help.txt || { echo "README.md usage differs from dmc-cc --help (sh bld/readme-help.sh --update)" >&2; exit 1; }
@@ -39,6 +39,19 @@
 #if !defined(ZATU_UNUSE_WCHAR_T)
 #include <cwchar>
 #endif
+#if !defined(ZATU_NO_SIMD) && !defined(__DMC__)
+ #if defined(__AVX2__)
+  #include <immintrin.h>
+  #define ZATU_CMDLINEARGS_AVX2
+ #endif
+ #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define ZATU_CMDLINEARGS_SSE2
+  #if defined(_MSC_VER)
+   #include <intrin.h>
+  #endif
+ #endif
+#endif
 
 #if !defined(ZATU_NOEXCEPT)
  #if __cplusplus >= 201103L || _MSVC_LANG >= 201103L
@@ -187,107 +200,245 @@ template<typename T, typename C> inline T strz_get(C const*& p) { return strz_to
 
 namespace _detail {
 
+    enum { SPAN_ARG, SPAN_DQ, SPAN_CMT };
+
     /**
-     *  Parse response string and insert into argv.
-     *  # Do not free malloc-memory, leave it to OS process termination.
+     *  Skip the chars tokenize_args only copies (SPAN_ARG, SPAN_DQ) or skips (SPAN_CMT).
+     *  @return the first char of [s,e) that needs a decision:
+     *      SPAN_ARG: <= 0x20, 0x7f, '"'    SPAN_DQ: '"', 0     SPAN_CMT: '\n', 0
      */
-    template<typename C> bool
-    insert_str_to_args(C const* bgn, C const* end, int index, int& rArgc, C**& rArgv, bool& rAlloc) ZATU_NOEXCEPT {
-        std::size_t max_arg_sz = 0;
-        C**         argv    = rArgv;
-        C**         arg_ary = NULL;
-        bool        rc      = true;
-        int         num     = 0;
-        for (int pass = 0; pass < 2; ++pass) {
-            C const*    s   = bgn;
-            bool        dq  = false;
-            bool        cmt = false;
-            bool        ltop = true;
-            std::size_t arg_sz = 0;
-            while (s < end) {
-                C   c = *s++;
-                if (c == 0)
-                    break;
-                if (!dq) {
-                    if (c == C('\n')) {
-                        cmt  = false;
-                        ltop = true;
-                    }
-                    if (cmt)
-                        continue;
-                    if (unsigned(c) <= 0x20 || c == 0x7f) {
-                        if (arg_sz) {
-                            if (max_arg_sz < arg_sz)
-                                max_arg_sz = arg_sz;
-                            if (pass) {
-                                argv[num] = str_n_dup(s-1 - arg_sz, arg_sz);
-                            }
-                            ++num;
-                        }
-                        arg_sz = 0;
-                        continue;
-                    } else if (c == C('"')) {
-                        dq = true;
-                        continue;
-                    } else if (c == C('#') && ltop) {
-                        cmt  = true;
-                        ltop = false;
-                        continue;
-                    }
-                } else {
-                    if (c == C('"')) {
-                        if (s < end && *s == C('"')) {
-                            ++s;
-                        } else {
-                            dq = false;
-                            continue;
-                        }
-                    }
-                }
-                ++arg_sz;
-                ltop = false;
-            }
-            if (arg_sz) {
-                if (max_arg_sz < arg_sz)
-                    max_arg_sz = arg_sz;
-                if (pass) {
-                    argv[num] = str_n_dup(s - 1 - arg_sz, arg_sz);
+    template<int M, typename C, typename K> inline K const*
+    span_plain(K const* s, K const* e) ZATU_NOEXCEPT {
+        for (; s < e; ++s) {
+            C c = C(*s);
+            if (M == SPAN_ARG ? (unsigned(c) <= 0x20 || c == 0x7f || c == C('"'))
+              : M == SPAN_DQ  ? (c == C('"') || c == 0)
+              :                 (c == C('\n') || c == 0))
+                break;
+        }
+        return s;
+    }
+
+ #if defined(ZATU_CMDLINEARGS_SSE2)
+    inline unsigned ctz32(unsigned m) ZATU_NOEXCEPT {
+     #if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward(&i, m);
+        return unsigned(i);
+     #else
+        return unsigned(__builtin_ctz(m));
+     #endif
+    }
+
+    template<int M> inline __m128i span_mask16(__m128i v) ZATU_NOEXCEPT {
+        if (M == SPAN_ARG) {
+            __m128i sp = _mm_set1_epi8(0x20);
+            __m128i m  = _mm_cmpeq_epi8(_mm_max_epu8(v, sp), sp);   // v <= 0x20 (unsigned)
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+            return _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+        }
+        __m128i m = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+        return _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(M == SPAN_DQ ? '"' : '\n')));
+    }
+
+  #if defined(ZATU_CMDLINEARGS_AVX2)
+    template<int M> inline __m256i span_mask32(__m256i v) ZATU_NOEXCEPT {
+        if (M == SPAN_ARG) {
+            __m256i sp = _mm256_set1_epi8(0x20);
+            __m256i m  = _mm256_cmpeq_epi8(_mm256_max_epu8(v, sp), sp);
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f)));
+            return _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+        }
+        __m256i m = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+        return _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(M == SPAN_DQ ? '"' : '\n')));
+    }
+  #endif
+
+    /// span_plain of char text, 32 (AVX2) or 16 (SSE2) chars at a time.
+    template<int M, typename C> inline char const*
+    span_plain(char const* s, char const* e) ZATU_NOEXCEPT {
+     #if defined(ZATU_CMDLINEARGS_AVX2)
+        if (e - s >= 16) {      // most arguments are short.
+            unsigned m = unsigned(_mm_movemask_epi8(span_mask16<M>(_mm_loadu_si128((__m128i const*)s))));
+            if (m)
+                return s + ctz32(m);
+            s += 16;
+        }
+        for (; e - s >= 32; s += 32) {
+            unsigned m = unsigned(_mm256_movemask_epi8(span_mask32<M>(_mm256_loadu_si256((__m256i const*)s))));
+            if (m)
+                return s + ctz32(m);
+        }
+     #endif
+        for (; e - s >= 16; s += 16) {
+            unsigned m = unsigned(_mm_movemask_epi8(span_mask16<M>(_mm_loadu_si128((__m128i const*)s))));
+            if (m)
+                return s + ctz32(m);
+        }
+        for (; s < e; ++s) {
+            unsigned char c = (unsigned char)*s;
+            if (M == SPAN_ARG ? (c <= 0x20 || c == 0x7f || c == '"')
+              : M == SPAN_DQ  ? (c == '"' || c == 0)
+              :                 (c == '\n' || c == 0))
+                break;
+        }
+        return s;
+    }
+ #endif
+
+    template<typename K, typename C> inline C*
+    copy_chars(C* d, K const* s, K const* e) ZATU_NOEXCEPT {
+        while (s < e)
+            *d++ = C(*s++);
+        return d;
+    }
+
+    inline char* copy_chars(char* d, char const* s, char const* e) ZATU_NOEXCEPT {
+        std::memcpy(d, s, std::size_t(e - s));
+        return d + (e - s);
+    }
+
+    /**
+     *  Split response text [bgn,end) into arguments, in one pass.
+     *  The unquoted arguments are written to dst as '\0' terminated strings
+     *  and their addresses to args.
+     *  dst needs (end - bgn + 1) chars, args (end - bgn + 1) / 2 + 1 entries.
+     *  Runs of plain chars are found by span_plain and copied at once.
+     *  Empty arguments ("") are dropped.
+     *  @return number of arguments.
+     */
+    template<typename K, typename C> int
+    tokenize_args(K const* bgn, K const* end, C* dst, C** args) ZATU_NOEXCEPT {
+        K const*    s    = bgn;
+        int         num  = 0;
+        bool        in   = false;   // in an argument.
+        bool        dq   = false;
+        bool        cmt  = false;
+        bool        ltop = true;
+        while (s < end) {
+            if (cmt) {
+                s = span_plain<SPAN_CMT, C>(s, end);
+            } else if (in && (dq || !ltop)) {   // '#' may start a comment while ltop.
+                K const* p = dq ? span_plain<SPAN_DQ, C>(s, end) : span_plain<SPAN_ARG, C>(s, end);
+                if (p > s) {
+                    dst  = copy_chars(dst, s, p);
+                    s    = p;
+                    ltop = false;
                 }
-                ++num;
             }
-            if (pass)
-                break;
-            if (num == 0)
+            if (s >= end)
                 break;
-            std::size_t arg_ary_size = (rArgc + num + 1) * sizeof(C*);
-            arg_ary = (C**)std::calloc(1, arg_ary_size);
-            if (!arg_ary) {
-                rc = false;
+            C   c = C(*s++);
+            if (c == 0)
                 break;
+            if (!dq) {
+                if (c == C('\n')) {
+                    cmt  = false;
+                    ltop = true;
+                }
+                if (cmt)
+                    continue;
+                if (unsigned(c) <= 0x20 || c == 0x7f) {
+                    if (in) {
+                        if (dst == args[num - 1])
+                            --num;
+                        else
+                            *dst++ = 0;
+                        in = false;
+                    }
+                    continue;
+                }
+                if (!in) {
+                    args[num++] = dst;
+                    in = true;
+                }
+                if (c == C('"')) {
+                    dq = true;
+                    continue;
+                } else if (c == C('#') && ltop) {
+                    --num;
+                    in   = false;
+                    cmt  = true;
+                    ltop = false;
+                    continue;
+                }
+            } else if (c == C('"')) {
+                if (s < end && *s == K('"')) {
+                    ++s;
+                } else {
+                    dq = false;
+                    continue;
+                }
             }
-            for (int i = 0; i < index; ++i)
-                arg_ary[i] = argv[i];
-            for (int i = index; i < rArgc; ++i)
-                arg_ary[i+num] = argv[i];
-            if (rAlloc)
-                std::free(argv);
-            rAlloc  = true;
-            rArgv   = arg_ary;
-            argv    = arg_ary;
-            rArgc   += num;
-            num     = index;
+            *dst++ = c;
+            ltop   = false;
         }
-        if (!rc)
-            std::free(arg_ary);
-        return rc;
+        if (in && dst == args[num - 1])
+            --num;
+        else if (in)
+            *dst = 0;
+        return num;
     }
 
+    /// malloc blocks freed all at once.
+    class args_arena {
+    public:
+        args_arena() : top_(NULL) {}
+        ~args_arena() {
+            while (top_) {
+                block* b = top_;
+                top_ = b->next;
+                std::free(b);
+            }
+        }
+        void* alloc(std::size_t bytes) ZATU_NOEXCEPT {
+            block* b = (block*)std::malloc(sizeof(block) + bytes);
+            if (b == NULL)
+                return NULL;
+            b->next = top_;
+            top_    = b;
+            return b + 1;
+        }
+    private:
+        union block {
+            block*      next;
+            long double align_;
+        };
+        block*  top_;
+    };
+
 }   // _detail
 
 
+/** Append a to response text, so that insert_response_str gives it back as one argument.
+ *  Quoted ("" for each '"') if it has spaces, control chars or '"', or starts with '#'.
+ */
+template<typename S, typename C> void
+append_response_arg(S& text, C const* a) {
+    bool quote = (*a == 0 || *a == C('#'));
+    for (C const* p = a; *p && !quote; ++p)
+        quote = (unsigned(*p) <= 0x20 || *p == 0x7f || *p == C('"'));
+    if (!quote) {
+        text += a;
+        return;
+    }
+    text += C('"');
+    for (C const* p = a; *p; ++p) {
+        if (*p == C('"'))
+            text += C('"');
+        text += *p;
+    }
+    text += C('"');
+}
+
+
 //  -   -   -   -   -   -   -   -   -   -   -   -   -   -
 
-/// Get command line arguments.
+/** Get command line arguments.
+ *  Arguments inserted from response strings live in an arena owned by this object.
+ *  The argument array is kept as [consumed | gap | pending], so that an argument
+ *  is replaced by a response string without moving the rest.
+ */
 template< unsigned int F=3, typename C=char>
 class cmd_line_args {
     enum flag { use_opt_next_arg = 1, enable_short_opt = 2, clr_opt_arg = 4 };
@@ -295,19 +446,20 @@ public:
     typedef C char_type;
 
     cmd_line_args(int argc, char_type* argv[]) ZATU_NOEXCEPT
-        : argv_(argv), arg_(&nil_), arg_0_(0), argc_(argc), index_(1)
+        : argv_(argv), arg_(&nil_), arg_0_(0), argc_(argc), index_(1), head_(1), end_(argc < 1 ? 1 : argc)
         , alloc_(false), enable_opt_(true), sub_opt_(false)
-        , short_idx_(0), pre_short_idx_(0), nil_(0)
+        , short_idx_(0), pre_short_idx_(0), nil_(0), resp_(NULL)
     { }
 
     ~cmd_line_args() {
-        //if (alloc_) std::free(argv_);
+        if (alloc_)
+            std::free(argv_);
     }
 
     int         argc() const ZATU_NOEXCEPT { return argc_; }
-    char_type** argv() ZATU_NOEXCEPT { return argv_; }
+    char_type** argv() ZATU_NOEXCEPT { close_gap(); return argv_; }
 
-    bool has_arg() const ZATU_NOEXCEPT { return (index_ < argc_); }
+    bool has_arg() const ZATU_NOEXCEPT { return (head_ < end_); }
 
     void disable_opt() ZATU_NOEXCEPT { enable_opt_ = false; }
 
@@ -435,7 +587,9 @@ public:
     }
 
     void reset() ZATU_NOEXCEPT {
-        index_ = 1;
+        close_gap();
+        index_ = head_ = 1;
+        resp_  = NULL;
         if ZATU_CONSTEXPR17 (F & clr_opt_arg)
             clear_opt_args<void>();
     }
@@ -449,26 +603,57 @@ public:
     }
 
     template<typename K> bool insert_response_str(K const* s) ZATU_NOEXCEPT {  // K=char
-        C const* e = s + std::char_traits<K>::length(s);
-        return _detail::insert_str_to_args(s, e, index_, argc_, argv_, alloc_);
+        return insert_response_str(s, s + std::char_traits<K>::length(s));
     }
 
     template<typename S> bool insert_response_str(S const& s, typename S::value_type* = NULL) ZATU_NOEXCEPT {  // S=string
         if (s.empty()) return false;
-        return _detail::insert_str_to_args(&s[0], &s[s.size()], index_, argc_, argv_, alloc_);
-        //return _detail::insert_str_to_args(*s.begin(), &*s.end(), index_, argc_, argv_, alloc_);
+        return insert_response_str(&s[0], &s[0] + s.size());
     }
 
+    /// Insert the arguments of [bgn,end) before the pending arguments.
+    /// name: response file name, for in_response().
+    template<typename K> bool insert_response_str(K const* bgn, K const* end, C const* name = NULL) ZATU_NOEXCEPT;
+
     template<typename K> bool replace_response_str(K const* s) ZATU_NOEXCEPT {
         erase_current_arg<void>();
         return insert_response_str(s);
     }
-    template<typename S> bool replace_response_str(S const& s) ZATU_NOEXCEPT {
+    template<typename S> bool replace_response_str(S const& s, typename S::value_type* = NULL) ZATU_NOEXCEPT {
         erase_current_arg<void>();
         return insert_response_str(s);
     }
+    template<typename K> bool replace_response_str(K const* bgn, K const* end, C const* name = NULL) ZATU_NOEXCEPT {
+        erase_current_arg<void>();
+        return insert_response_str(bgn, end, name);
+    }
+
+    /// true if the current argument comes from the response file name. (recursion check)
+    bool in_response(C const* name) ZATU_NOEXCEPT {
+        int pending = end_ - head_;
+        while (resp_ && resp_->rest > pending)
+            resp_ = resp_->prev;
+        for (resp_t const* r = resp_; r; r = r->prev) {
+            if (std::char_traits<C>::compare(r->name, name, std::char_traits<C>::length(name) + 1) == 0)
+                return true;
+        }
+        return false;
+    }
 
 private:
+    cmd_line_args(cmd_line_args const&);
+    cmd_line_args& operator=(cmd_line_args const&);
+
+    /// A response file being expanded. Its arguments are pending while more than rest remain.
+    struct resp_t {
+        C const*    name;
+        int         rest;
+        resp_t*     prev;
+    };
+
+    bool    reserve_gap(int num) ZATU_NOEXCEPT;
+    void    close_gap() ZATU_NOEXCEPT;
+
     C*      get_opt1(C const* opt) ZATU_NOEXCEPT;
     C*      get_opt_arg(C* opt_arg, bool next_arg) ZATU_NOEXCEPT;
 
@@ -491,39 +676,40 @@ private:
         }
     }
 
+    /// Drop the current argument. (its sub argument, if any, goes back to pending)
     template<class DMY>
     void    erase_current_arg() ZATU_NOEXCEPT {
-        if (index_) {
-            --index_;
-            if (index_ && sub_opt_)
-                --index_;
-        }
-        for (std::size_t i = index_ + 1; i < argc_; ++i) {
-            argv_[i - 1] = argv_[i];
-        }
-        if (argc_) {
-            --argc_;
-            argv_[argc_] = NULL;
+        if (index_ == 0)
+            return;
+        if (index_ > 1 && sub_opt_) {
+            argv_[--head_] = argv_[--index_];
+            sub_opt_ = false;
         }
+        --index_;
+        --argc_;
     }
 
 private:
     char_type**     argv_;
     char_type*      arg_;
     char_type*      arg_0_;
-    int             argc_;
-    int             index_;
+    int             argc_;      // consumed + pending.
+    int             index_;     // end of consumed.
+    int             head_;      // begin of pending.
+    int             end_;       // end of pending. argv_[end_] == NULL
     bool            alloc_;
     bool            enable_opt_;
     bool            sub_opt_;
     unsigned char   short_idx_;
     unsigned char   pre_short_idx_;
     char_type       nil_;
+    resp_t*         resp_;
+    _detail::args_arena arena_;
 };
 
 template<unsigned int F, typename C>
 bool cmd_line_args<F,C>::prepare_get() ZATU_NOEXCEPT {
-    assert(index_ < argc_);
+    assert(head_ < end_);
     if (short_idx_) {
         if (*arg_) {
             if (pre_short_idx_ < short_idx_) {
@@ -536,7 +722,7 @@ bool cmd_line_args<F,C>::prepare_get() ZATU_NOEXCEPT {
     }
     sub_opt_ = false;
     pre_short_idx_ = short_idx_;
-    arg_ = arg_0_ = argv_[index_++];
+    arg_ = arg_0_ = argv_[index_++] = argv_[head_++];
     bool rc = enable_opt_ && arg_ && *arg_ == '-';
     if ZATU_CONSTEXPR17 (F & clr_opt_arg) {
         if (rc)
@@ -587,9 +773,9 @@ C* cmd_line_args<F,C>::get_opt_arg(C* opt_arg, bool next_arg) ZATU_NOEXCEPT {
     if ZATU_CONSTEXPR17 (F & use_opt_next_arg) {
         assert(opt_arg != 0);
         sub_opt_ = false;
-        if (next_arg && *opt_arg == 0 && index_ < argc_) {
+        if (next_arg && *opt_arg == 0 && head_ < end_) {
             sub_opt_ = true;
-            opt_arg = argv_[index_++];
+            opt_arg = argv_[index_++] = argv_[head_++];
             if ZATU_CONSTEXPR17 (F & clr_opt_arg)
                 argv_[index_-1] = NULL;
         }
@@ -597,6 +783,74 @@ C* cmd_line_args<F,C>::get_opt_arg(C* opt_arg, bool next_arg) ZATU_NOEXCEPT {
     return opt_arg;
 }
 
+template<unsigned int F, typename C>
+template<typename K>
+bool cmd_line_args<F,C>::insert_response_str(K const* bgn, K const* end, C const* name) ZATU_NOEXCEPT {
+    std::size_t len      = std::size_t(end - bgn);
+    std::size_t name_len = name ? std::char_traits<C>::length(name) + 1 : 0;
+    std::size_t max_num  = (len + 1) / 2 + 1;
+    C*  buf  = (C*)arena_.alloc(sizeof(resp_t) + (len + 1 + name_len) * sizeof(C));
+    C** args = (C**)std::malloc(max_num * sizeof(C*));
+    if (buf == NULL || args == NULL) {
+        std::free(args);
+        return false;
+    }
+    int num = _detail::tokenize_args(bgn, end, buf + sizeof(resp_t) / sizeof(C), args);
+    if (num > 0 && !reserve_gap(num)) {
+        std::free(args);
+        return false;
+    }
+    if (name) {
+        resp_t* r = (resp_t*)buf;
+        C*      n = buf + sizeof(resp_t) / sizeof(C) + len + 1;
+        std::memcpy(n, name, name_len * sizeof(C));
+        r->name = n;
+        r->rest = end_ - head_;
+        r->prev = resp_;
+        resp_   = r;
+    }
+    head_ -= num;
+    std::memcpy(argv_ + head_, args, num * sizeof(C*));
+    argc_ += num;
+    std::free(args);
+    return num > 0;
+}
+
+/// Make room for num arguments before the pending ones. (the array grows by 1.5x)
+template<unsigned int F, typename C>
+bool cmd_line_args<F,C>::reserve_gap(int num) ZATU_NOEXCEPT {
+    if (head_ - index_ >= num)
+        return true;
+    int pending = end_ - head_;
+    int need    = index_ + num + pending;
+    int cap     = need + need / 2 + 16;
+    C** a = (C**)std::malloc((cap + 1) * sizeof(C*));
+    if (a == NULL)
+        return false;
+    std::memcpy(a, argv_, index_ * sizeof(C*));
+    std::memcpy(a + cap - pending, argv_ + head_, pending * sizeof(C*));
+    a[cap] = NULL;
+    if (alloc_)
+        std::free(argv_);
+    alloc_ = true;
+    argv_  = a;
+    head_  = cap - pending;
+    end_   = cap;
+    return true;
+}
+
+/// Make argv_[0, argc_) contiguous.
+template<unsigned int F, typename C>
+void cmd_line_args<F,C>::close_gap() ZATU_NOEXCEPT {
+    if (head_ <= index_)
+        return;
+    int pending = end_ - head_;
+    std::memmove(argv_ + index_, argv_ + head_, pending * sizeof(C*));
+    head_ = index_;
+    end_  = index_ + pending;
+    argv_[end_] = NULL;
+}
+
 namespace cmd_line_args_util {}
 
 }   // zatu
@@ -0,0 +1,116 @@
+/**
+ *  @file   dmc-cc-ar.hpp
+ *  @brief  Member list of an archive made by dmc-ar, so that lib.exe can rebuild it at once.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    LIB.dmc-ar, rewritten by each dmc-ar call on LIB:
+ *      dmc-ar 1
+ *      P               (if the members are not in LIB yet)
+ *      M \t PATH       each member object, in the archive order.
+ *    A member is identified by its file name, as ar does.
+ */
+#ifndef DMC_CC_AR_HPP_INCLUDED
+#define DMC_CC_AR_HPP_INCLUDED
+
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <vector>
+#include "file_util.hpp"
+
+class ArchiveMembers {
+public:
+    explicit ArchiveMembers(std::string const& lib) : path_(lib + ".dmc-ar"), pending_(false) {}
+
+    std::string const& path() const { return path_; }
+    std::vector<std::string> const& members() const { return members_; }
+    bool pending() const { return pending_; }
+    void set_pending(bool f) { pending_ = f; }
+
+    /// @return false if there is no list. (LIB is not made by dmc-ar)
+    bool load() {
+        std::string text;
+        members_.clear();
+        pending_ = false;
+        if (!zatu::file_util::file_read(path_.c_str(), text) || text.compare(0, 9, "dmc-ar 1\n") != 0)
+            return false;
+        std::size_t pos = 9;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;
+            std::string line = text.substr(pos, eol - pos);
+            pos = eol + 1;
+            if (line == "P")
+                pending_ = true;
+            else if (line.compare(0, 2, "M\t") == 0)
+                members_.push_back(line.substr(2));
+        }
+        return true;
+    }
+
+    bool save() const {
+        std::string s = "dmc-ar 1\n";
+        if (pending_)
+            s += "P\n";
+        for (std::size_t i = 0; i < members_.size(); ++i)
+            s += "M\t" + members_[i] + "\n";
+        return zatu::file_util::file_save_atomic(path_.c_str(), s);
+    }
+
+    void clear() {
+        members_.clear();
+        pending_ = false;
+    }
+
+    /// Add objs. A member of the same name is replaced in place. (also by ar q: lib.exe takes no duplicates)
+    void put(std::vector<std::string> const& objs) {
+        for (std::size_t i = 0; i < objs.size(); ++i) {
+            std::size_t k = find(objs[i]);
+            if (k < members_.size())
+                members_[k] = objs[i];
+            else
+                members_.push_back(objs[i]);
+        }
+    }
+
+    /// Remove the members named as names. @return number of names not found.
+    std::size_t remove(std::vector<std::string> const& names) {
+        std::size_t missing = 0;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            std::size_t k = find(names[i]);
+            if (k < members_.size())
+                members_.erase(members_.begin() + k);
+            else
+                ++missing;
+        }
+        return missing;
+    }
+
+    /// Index of the member of the name of path. (members().size(): none)
+    std::size_t find(std::string const& path) const {
+        std::string name = name_of(path);
+        for (std::size_t i = 0; i < members_.size(); ++i) {
+            if (name_of(members_[i]) == name)
+                return i;
+        }
+        return members_.size();
+    }
+
+    /// File name of path. (lower case: lib.exe does not tell the case)
+    static std::string name_of(std::string const& path) {
+        std::string name = path.substr(path.find_last_of("/\\:") + 1);
+        for (std::size_t i = 0; i < name.size(); ++i)
+            name[i] = char(std::tolower((unsigned char)name[i]));
+        return name;
+    }
+
+private:
+    std::string                 path_;
+    std::vector<std::string>    members_;
+    bool                        pending_;
+};
+
+#endif  // DMC_CC_AR_HPP_INCLUDED
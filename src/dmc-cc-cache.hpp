@@ -0,0 +1,84 @@
+/**
+ *  @file   dmc-cc-cache.hpp
+ *  @brief  Content addressed object cache of dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    DIR/xx/KEY.obj    object file.
+ *    DIR/xx/KEY.txt    compiler output (warnings).
+ *    DIR/stats.log     one line per lookup. "h":hit "m":miss
+ *    Entries are written by rename, so concurrent make -j processes are safe.
+ */
+#ifndef DMC_CC_CACHE_HPP_INCLUDED
+#define DMC_CC_CACHE_HPP_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include "file_util.hpp"
+
+class ObjCache {
+public:
+    ObjCache() {}
+
+    bool enabled() const { return !dir_.empty(); }
+
+    void set_dir(std::string const& dir) { dir_ = dir; }
+
+    std::string const& dir() const { return dir_; }
+
+    /// Copy the cached object of key to obj. out receives the stored compiler output.
+    bool get(std::string const& key, char const* obj, std::string& out) const {
+        std::string path = entry_path(key, ".obj");
+        if (!zatu::file_util::file_copy(path.c_str(), obj))
+            return false;
+        zatu::file_util::file_read(entry_path(key, ".txt").c_str(), out);
+        return true;
+    }
+
+    void put(std::string const& key, char const* obj, std::string const& out) const {
+        std::string path = entry_path(key, ".obj");
+        std::string dir  = path.substr(0, path.find_last_of("/\\"));
+        if (!zatu::file_util::make_dirs(dir))
+            return;
+        if (!out.empty())
+            zatu::file_util::file_save_atomic(entry_path(key, ".txt").c_str(), out);
+        zatu::file_util::file_copy(obj, path.c_str());
+    }
+
+    void count(bool hit) const {
+        if (zatu::file_util::make_dirs(dir_))
+            zatu::file_util::file_append(stats_path().c_str(), hit ? "h\n" : "m\n", 2);
+    }
+
+    int print_stats() const {
+        std::string s;
+        zatu::file_util::file_read(stats_path().c_str(), s);
+        unsigned long hit = 0, miss = 0;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == 'h')
+                ++hit;
+            else if (s[i] == 'm')
+                ++miss;
+        }
+        std::printf("cache directory: %s\n", dir_.c_str());
+        std::printf("cache hit:       %lu\n", hit);
+        std::printf("cache miss:      %lu\n", miss);
+        return 0;
+    }
+
+private:
+    std::string entry_path(std::string const& key, char const* ext) const {
+        std::string sub = zatu::file_util::path_join(dir_, key.substr(0, 2));
+        return zatu::file_util::path_join(sub, key + ext);
+    }
+
+    std::string stats_path() const {
+        return zatu::file_util::path_join(dir_, "stats.log");
+    }
+
+private:
+    std::string dir_;
+};
+
+#endif  // DMC_CC_CACHE_HPP_INCLUDED
@@ -0,0 +1,396 @@
+/**
+ *  @file   dmc-cc-deps.hpp
+ *  @brief  #include scanner and gcc style dependency (.d) file writer.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    #if/#ifdef are not evaluated, so the result is a superset of what dmc reads.
+ *    The #include lines of each file are kept in an append-only cache file,
+ *    one line per file, and reused while the file's size and mtime are the same:
+ *      #2
+ *      PATH \t SIZE \t MTIME \t "name \t <name \t ? ...
+ *    "?" is an #include of a macro. A file without the "#2" line is rebuilt.
+ */
+#ifndef DMC_CC_DEPS_HPP_INCLUDED
+#define DMC_CC_DEPS_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "file_util.hpp"
+
+class IncludeScanner {
+public:
+    IncludeScanner() : loaded_(false), rewrite_(false), computed_(false) {}
+
+    ~IncludeScanner() { save(); }
+
+    /// Cache file of #include lines. (empty: no persistent cache)
+    void set_cache_path(std::string const& path) { cache_path_ = path; }
+
+    /// -I directories and system (INCLUDE, dmc\include) directories.
+    void set_dirs(std::vector<std::string> const& user_dirs, std::vector<std::string> const& sys_dirs) {
+        user_dirs_ = user_dirs;
+        sys_dirs_  = sys_dirs;
+    }
+
+    /** Collect src, forced includes and all headers they include.
+     *  If user_only is true, headers found in system directories are left out.
+     *  dirs receives the directory that satisfied each header. (empty: same directory or forced)
+     *  misses receives the paths a lookup tried that did not exist, in order.
+     *  (a header created as one of them later would shadow the found one)
+     *  computed() tells whether a file of them has an #include of a macro.
+     */
+    void scan(std::string const& src, std::vector<std::string> const& forced, bool user_only
+              , std::vector<std::string>& deps, std::vector<std::string>* dirs = NULL
+              , std::vector<std::string>* misses = NULL)
+    {
+        load();
+        computed_ = false;
+        misses_.clear();
+        missed_.clear();
+        std::set<std::string> done;
+        deps.clear();
+        deps.push_back(src);
+        if (dirs)
+            dirs->assign(1, std::string());
+        done.insert(src);
+        std::vector<std::string> stack;
+        for (std::size_t i = 0; i < forced.size(); ++i) {
+            std::string path, dir;
+            bool        sys = false;
+            if (resolve(forced[i], true, std::string(), path, dir, sys) && done.insert(path).second) {
+                stack.push_back(path);
+                if (!(user_only && sys)) {
+                    deps.push_back(path);
+                    if (dirs)
+                        dirs->push_back(dir);
+                }
+            }
+        }
+        stack.push_back(src);
+        while (!stack.empty()) {
+            std::string cur = stack.back();
+            stack.pop_back();
+            std::vector<std::string> const* incs = includes(cur);
+            if (incs == NULL)
+                continue;
+            std::string cur_dir = dir_of(cur);
+            for (std::size_t i = 0; i < incs->size(); ++i) {
+                std::string const& inc = (*incs)[i];
+                if (inc == "?") {
+                    computed_ = true;
+                    continue;
+                }
+                std::string path, dir;
+                bool        sys = false;
+                if (!resolve(inc.substr(1), inc[0] == '"', cur_dir, path, dir, sys))
+                    continue;
+                if (!done.insert(path).second)
+                    continue;
+                stack.push_back(path);
+                if (!(user_only && sys)) {
+                    deps.push_back(path);
+                    if (dirs)
+                        dirs->push_back(dir);
+                }
+            }
+        }
+        if (misses)
+            misses->assign(misses_.begin(), misses_.end());
+    }
+
+    bool computed() const { return computed_; }
+
+    /// Directory of a path of misses. ("d/sub/x.h" -> "d/sub", whose stamp changes when x.h or sub is made)
+    static std::string miss_dir(std::string const& path) {
+        std::string d = dir_of(path);
+        if (d.size() > 1 && (d[d.size() - 1] == '/' || d[d.size() - 1] == '\\') && d[d.size() - 2] != ':')
+            d.erase(d.size() - 1);
+        return d.empty() ? std::string(".") : d;
+    }
+
+    /// Append new entries to the cache file.
+    void save() {
+        if (cache_path_.empty() || pending_.empty())
+            return;
+        std::string dir = cache_path_.substr(0, cache_path_.find_last_of("/\\") + 1);
+        if (!dir.empty() && !zatu::file_util::make_dirs(dir))
+            return;
+        if (rewrite_)
+            zatu::file_util::file_save_atomic(cache_path_.c_str(), version() + pending_);
+        else
+            zatu::file_util::file_append(cache_path_.c_str(), pending_);
+        rewrite_ = false;
+        pending_.clear();
+    }
+
+    /// Write a make rule "targets: deps" to path. (phony: "dep:" for each header)
+    static bool write_depfile(char const* path, std::string const& targets
+                              , std::vector<std::string> const& deps, bool phony)
+    {
+        std::string s = targets + ":";
+        for (std::size_t i = 0; i < deps.size(); ++i)
+            s += " \\\n  " + make_escape(deps[i]);
+        s += "\n";
+        if (phony) {
+            for (std::size_t i = 1; i < deps.size(); ++i)
+                s += "\n" + make_escape(deps[i]) + ":\n";
+        }
+        return zatu::file_util::file_save_atomic(path, s);
+    }
+
+    /// '\' -> '/', ' ' -> "\ ", '$' -> "$$", '#' -> "\#"
+    static std::string make_escape(std::string const& path) {
+        std::string s;
+        s.reserve(path.size() + 8);
+        for (std::size_t i = 0; i < path.size(); ++i) {
+            char c = path[i];
+            if (c == '\\')
+                s += '/';
+            else if (c == ' ' || c == '#')
+                (s += '\\') += c;
+            else if (c == '$')
+                s += "$$";
+            else
+                s += c;
+        }
+        return s;
+    }
+
+private:
+    struct Entry {
+        unsigned long long          size;
+        unsigned long long          mtime;
+        std::vector<std::string>    incs;   // '"' or '<' + name.
+    };
+    typedef std::map<std::string, Entry>    entry_map;
+    typedef std::map<std::string, bool>     exist_map;
+
+    static std::string dir_of(std::string const& path) {
+        std::size_t p = path.find_last_of("/\\:");
+        return (p == std::string::npos) ? std::string() : path.substr(0, p + 1);
+    }
+
+    static bool is_abs(std::string const& path) {
+        return !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+    }
+
+    bool exists(std::string const& path) {
+        exist_map::iterator it = exists_.find(path);
+        if (it != exists_.end())
+            return it->second;
+        zatu::file_util::file_stat_t st;
+        bool rc = zatu::file_util::file_stat(path.c_str(), st) && !st.is_dir;
+        exists_[path] = rc;
+        return rc;
+    }
+
+    bool resolve(std::string const& name, bool quoted, std::string const& cur_dir
+                 , std::string& path, std::string& dir, bool& sys)
+    {
+        if (name.empty())
+            return false;
+        sys = false;
+        dir.clear();
+        if (is_abs(name)) {
+            path = name;
+            return exists(path);
+        }
+        if (quoted) {
+            path = cur_dir + name;
+            if (exists(path))
+                return true;
+            missed(path);
+        }
+        for (std::size_t i = 0; i < user_dirs_.size(); ++i) {
+            path = zatu::file_util::path_join(user_dirs_[i], name);
+            if (exists(path)) {
+                dir = user_dirs_[i];
+                return true;
+            }
+            missed(path);
+        }
+        for (std::size_t i = 0; i < sys_dirs_.size(); ++i) {
+            path = zatu::file_util::path_join(sys_dirs_[i], name);
+            if (exists(path)) {
+                dir = sys_dirs_[i];
+                sys = true;
+                return true;
+            }
+            missed(path);
+        }
+        return false;
+    }
+
+    void missed(std::string const& path) {
+        if (missed_.insert(path).second)
+            misses_.push_back(path);
+    }
+
+    /// #include lines of path, from the cache or by parsing the file.
+    std::vector<std::string> const* includes(std::string const& path) {
+        zatu::file_util::file_stat_t st;
+        if (!zatu::file_util::file_stat(path.c_str(), st) || st.is_dir)
+            return NULL;
+        entry_map::iterator it = entries_.find(path);
+        if (it != entries_.end() && it->second.size == st.size && it->second.mtime == st.mtime)
+            return &it->second.incs;
+        std::string text;
+        if (!zatu::file_util::file_read(path.c_str(), text))
+            return NULL;
+        Entry& e = entries_[path];
+        e.size  = st.size;
+        e.mtime = st.mtime;
+        parse(text, e.incs);
+        if (!cache_path_.empty()) {
+            char buf[64];
+            std::sprintf(buf, "\t%llu\t%llu", e.size, e.mtime);
+            pending_ += path + buf;
+            for (std::size_t i = 0; i < e.incs.size(); ++i)
+                pending_ += "\t" + e.incs[i];
+            pending_ += "\n";
+        }
+        return &e.incs;
+    }
+
+    /// Pick "name" / <name> of #include lines, skipping comments.
+    static void parse(std::string const& text, std::vector<std::string>& incs) {
+        incs.clear();
+        char const* s   = text.c_str();
+        char const* e   = s + text.size();
+        bool        cmt = false;    // in /* */
+        while (s < e) {
+            char const* eol = s;
+            while (eol < e && *eol != '\n')
+                ++eol;
+            char const* p = s;
+            s = eol + 1;
+            if (cmt) {
+                while (p + 1 < eol && !(p[0] == '*' && p[1] == '/'))
+                    ++p;
+                if (p + 1 >= eol)
+                    continue;
+                cmt = false;
+                p  += 2;
+            }
+            while (p < eol && (*p == ' ' || *p == '\t'))
+                ++p;
+            if (p < eol && *p == '#') {
+                ++p;
+                while (p < eol && (*p == ' ' || *p == '\t'))
+                    ++p;
+                if (eol - p > 7 && std::strncmp(p, "include", 7) == 0) {
+                    p += 7;
+                    while (p < eol && (*p == ' ' || *p == '\t'))
+                        ++p;
+                    char c = (p < eol) ? *p : 0;
+                    char t = (c == '"') ? '"' : (c == '<') ? '>' : 0;
+                    if (t) {
+                        char const* q = ++p;
+                        while (q < eol && *q != t)
+                            ++q;
+                        if (q < eol && q > p)
+                            incs.push_back(c + std::string(p, q));
+                    } else if (p < eol && *p != '\r') {
+                        incs.push_back("?");
+                    }
+                }
+            }
+            // the rest of the line only matters for an open /* comment.
+            for (; p + 1 < eol; ++p) {
+                if (p[0] == '/' && p[1] == '/')
+                    break;
+                if (p[0] == '/' && p[1] == '*') {
+                    char const* q = p + 2;
+                    while (q + 1 < eol && !(q[0] == '*' && q[1] == '/'))
+                        ++q;
+                    if (q + 1 >= eol) {
+                        cmt = true;
+                        break;
+                    }
+                    p = q + 1;
+                }
+            }
+        }
+    }
+
+    static std::string version() { return "#2\n"; }
+
+    /// Load the cache file. Rewrite it when most of its lines are stale.
+    void load() {
+        if (loaded_ || cache_path_.empty())
+            return;
+        loaded_ = true;
+        std::string text;
+        if (!zatu::file_util::file_read(cache_path_.c_str(), text) || text.compare(0, 3, version()) != 0) {
+            rewrite_ = true;    // none, or of an older dmc-cc.
+            return;
+        }
+        std::size_t lines = 0;
+        std::size_t pos   = 3;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;      // a line being appended.
+            std::vector<std::string> f;
+            split(text.substr(pos, eol - pos), f);
+            pos = eol + 1;
+            ++lines;
+            if (f.size() < 3)
+                continue;
+            Entry& en = entries_[f[0]];
+            en.size  = 0;
+            en.mtime = 0;
+            std::sscanf(f[1].c_str(), "%llu", &en.size);
+            std::sscanf(f[2].c_str(), "%llu", &en.mtime);
+            en.incs.assign(f.begin() + 3, f.end());
+        }
+        if (lines > 1024 && entries_.size() * 2 < lines)
+            compact();
+    }
+
+    void compact() {
+        std::string s = version();
+        for (entry_map::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            char buf[64];
+            std::sprintf(buf, "\t%llu\t%llu", it->second.size, it->second.mtime);
+            s += it->first + buf;
+            for (std::size_t i = 0; i < it->second.incs.size(); ++i)
+                s += "\t" + it->second.incs[i];
+            s += "\n";
+        }
+        zatu::file_util::file_save_atomic(cache_path_.c_str(), s);
+    }
+
+    static void split(std::string const& line, std::vector<std::string>& f) {
+        std::size_t b = 0;
+        for (;;) {
+            std::size_t t = line.find('\t', b);
+            f.push_back(line.substr(b, t - b));
+            if (t == std::string::npos)
+                break;
+            b = t + 1;
+        }
+    }
+
+private:
+    std::vector<std::string>    user_dirs_;
+    std::vector<std::string>    sys_dirs_;
+    std::vector<std::string>    misses_;
+    std::set<std::string>       missed_;
+    entry_map                   entries_;
+    exist_map                   exists_;
+    std::string                 cache_path_;
+    std::string                 pending_;
+    bool                        loaded_;
+    bool                        rewrite_;   // the cache file is replaced by save().
+    bool                        computed_;
+};
+
+#endif  // DMC_CC_DEPS_HPP_INCLUDED
@@ -0,0 +1,160 @@
+/**
+ *  @file   dmc-cc-diag.hpp
+ *  @brief  Rewrite dmc diagnostics into the gcc form, line by line.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    dmc:
+ *          x = y;
+ *              ^
+ *      src\a.c(3) : Error: undefined identifier 'y'
+ *      src\a.c(9) : Warning 2: possible unintended assignment
+ *    gcc:
+ *      src/a.c:3:9: error: undefined identifier 'y'
+ *          x = y;
+ *              ^
+ *      src/a.c:9: warning: possible unintended assignment [-w2]
+ *    The column is taken from the caret line. At most two lines (the source
+ *    line and the caret) are held back until the diagnostic after them.
+ */
+#ifndef DMC_CC_DIAG_HPP_INCLUDED
+#define DMC_CC_DIAG_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class DiagTranslator {
+public:
+    DiagTranslator() : held_(0) {}
+
+    /// Translate the complete lines of [p, p+n) into out. A partial line is kept for the next call.
+    void feed(char const* p, std::size_t n, std::string& out) {
+        part_.append(p, n);
+        std::size_t pos = 0;
+        for (;;) {
+            std::size_t eol = part_.find('\n', pos);
+            if (eol == std::string::npos)
+                break;
+            std::size_t e = (eol > pos && part_[eol - 1] == '\r') ? eol - 1 : eol;
+            line(part_.substr(pos, e - pos), out);
+            pos = eol + 1;
+        }
+        part_.erase(0, pos);
+    }
+
+    /// Flush the held lines and a last line without '\n'.
+    void finish(std::string& out) {
+        if (!part_.empty())
+            line(part_, out);
+        part_.clear();
+        flush_held(out);
+    }
+
+    /// Translate the whole text. (captured output)
+    static std::string translate(std::string const& text) {
+        DiagTranslator t;
+        std::string    out;
+        t.feed(text.data(), text.size(), out);
+        t.finish(out);
+        return out;
+    }
+
+private:
+    void line(std::string const& s, std::string& out) {
+        std::string file, lno, kind, msg;
+        if (parse(s, file, lno, kind, msg)) {
+            if (held_ != 2)     // not the source of this one.
+                flush_held(out);
+            for (std::size_t i = 0; i < file.size(); ++i) {
+                if (file[i] == '\\')
+                    file[i] = '/';
+            }
+            out += file + ":" + lno + ":";
+            if (!caret_.empty()) {
+                char buf[16];
+                std::sprintf(buf, "%u:", unsigned(caret_.find('^') + 1));
+                out += buf;
+            }
+            out += " " + kind + ": " + msg + "\n";
+            flush_held(out);
+            return;
+        }
+        if (held_ == 1 && is_caret(s)) {
+            caret_ = s;
+            held_  = 2;
+            return;
+        }
+        flush_held(out);
+        if (s.empty() || is_caret(s)) {
+            out += s + "\n";
+        } else {
+            src_  = s;
+            held_ = 1;
+        }
+    }
+
+    void flush_held(std::string& out) {
+        if (held_ >= 1)
+            out += src_ + "\n";
+        if (held_ >= 2)
+            out += caret_ + "\n";
+        src_.clear();
+        caret_.clear();
+        held_ = 0;
+    }
+
+    static bool is_caret(std::string const& s) {
+        std::size_t c = s.find_first_not_of(" \t");
+        return c != std::string::npos && s[c] == '^' && s.find_first_not_of(" \t", c + 1) == std::string::npos;
+    }
+
+    /// "FILE(LINE) : KIND[ N]: MSG"
+    static bool parse(std::string const& s, std::string& file, std::string& lno, std::string& kind, std::string& msg) {
+        std::size_t sep = s.find(") : ");
+        if (sep == std::string::npos)
+            return false;
+        std::size_t lp = s.rfind('(', sep);
+        if (lp == std::string::npos || lp == 0 || lp + 1 == sep)
+            return false;
+        for (std::size_t i = lp + 1; i < sep; ++i) {
+            if (s[i] < '0' || s[i] > '9')
+                return false;
+        }
+        std::size_t k = sep + 4;
+        std::size_t c = s.find(": ", k);
+        if (c == std::string::npos)
+            return false;
+        std::string what = s.substr(k, c - k);
+        std::string num;
+        std::size_t sp = what.find_last_of(' ');
+        if (sp != std::string::npos && what.find_first_not_of("0123456789", sp + 1) == std::string::npos) {
+            num = what.substr(sp + 1);
+            what.resize(sp);
+        }
+        if (what.find("arning") != std::string::npos)
+            kind = "warning";
+        else if (what.find("atal") != std::string::npos)
+            kind = "fatal error";
+        else if (what.find("rror") != std::string::npos)
+            kind = "error";
+        else
+            return false;
+        file = s.substr(0, lp);
+        lno  = s.substr(lp + 1, sep - lp - 1);
+        msg  = s.substr(c + 2);
+        if (!num.empty() && kind == "warning")
+            msg += " [-w" + num + "]";
+        return true;
+    }
+
+private:
+    std::string     part_;      // incomplete line.
+    std::string     src_;       // held source line.
+    std::string     caret_;     // held caret line.
+    int             held_;      // 0, 1:src_, 2:src_ and caret_
+};
+
+#endif  // DMC_CC_DIAG_HPP_INCLUDED
@@ -0,0 +1,104 @@
+/**
+ *  @file   dmc-cc-history.hpp
+ *  @brief  Past compile time of each TU, to start the longest ones first.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    STATE_DIR/durations.txt, one line per finished compile, appended:
+ *      KEY \t MS
+ *    KEY is the hash of the options and the full path of the source, MS the time it took.
+ *    The time of a key is the mean of its last two lines.
+ */
+#ifndef DMC_CC_HISTORY_HPP_INCLUDED
+#define DMC_CC_HISTORY_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <map>
+#include "file_util.hpp"
+
+class CompileHistory {
+public:
+    CompileHistory() : loaded_(false) {}
+
+    void set_path(std::string const& path) { path_ = path; }
+
+    /// Time of key in ms: the mean of the last two runs. (false: no history)
+    bool find(std::string const& key, double& ms) {
+        load();
+        time_map::const_iterator it = times_.find(key);
+        if (it == times_.end())
+            return false;
+        ms = (it->second.runs < 2) ? it->second.last : (it->second.prev + it->second.last) / 2;
+        return true;
+    }
+
+    /// Record a compile of key that took ms. The line is written at once.
+    void add(std::string const& key, double ms) {
+        load();
+        times_[key].push(ms);
+        char buf[32];
+        std::sprintf(buf, "\t%.1f\n", ms);
+        std::string dir = path_.substr(0, path_.find_last_of("/\\") + 1);
+        if (!path_.empty() && (dir.empty() || zatu::file_util::make_dirs(dir)))
+            zatu::file_util::file_append(path_.c_str(), key + buf);
+    }
+
+private:
+    struct Times {
+        double  last;
+        double  prev;
+        int     runs;       // 1 or 2.
+        Times() : last(0), prev(0), runs(0) {}
+        void push(double ms) { prev = last; last = ms; runs = (runs < 2) ? runs + 1 : 2; }
+    };
+    typedef std::map<std::string, Times>    time_map;
+
+    /// Load the file. Rewrite it when most of its lines are stale.
+    void load() {
+        if (loaded_ || path_.empty())
+            return;
+        loaded_ = true;
+        std::string text;
+        if (!zatu::file_util::file_read(path_.c_str(), text))
+            return;
+        std::size_t lines = 0;
+        std::size_t pos   = 0;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;      // a line being appended.
+            std::size_t tab = text.find('\t', pos);
+            if (tab < eol)
+                times_[text.substr(pos, tab - pos)].push(std::strtod(text.c_str() + tab + 1, NULL));
+            pos = eol + 1;
+            ++lines;
+        }
+        if (lines > 1024 && times_.size() * 4 < lines)
+            compact();
+    }
+
+    /// Keep the last two lines of each key.
+    void compact() {
+        std::string s;
+        char        buf[32];
+        for (time_map::const_iterator it = times_.begin(); it != times_.end(); ++it) {
+            if (it->second.runs > 1) {
+                std::sprintf(buf, "\t%.1f\n", it->second.prev);
+                s += it->first + buf;
+            }
+            std::sprintf(buf, "\t%.1f\n", it->second.last);
+            s += it->first + buf;
+        }
+        zatu::file_util::file_save_atomic(path_.c_str(), s);
+    }
+
+private:
+    std::string     path_;
+    time_map        times_;
+    bool            loaded_;
+};
+
+#endif  // DMC_CC_HISTORY_HPP_INCLUDED
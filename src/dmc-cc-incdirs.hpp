@@ -0,0 +1,171 @@
+/**
+ *  @file   dmc-cc-incdirs.hpp
+ *  @brief  The -I options each TU finds its headers through, for --CC-prune-includes.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    One line per TU, appended. The last line of a key wins:
+ *      KEY \t USED \t PATH \t SIZE \t MTIME [\t PATH \t SIZE \t MTIME ...]
+ *    KEY is the hash of the source path and the options. USED is the indexes of
+ *    the -I options in use, comma separated ("*": all). PATHs are the source, its
+ *    headers and the -I directories. The line is used while none of them changed.
+ */
+#ifndef DMC_CC_INCDIRS_HPP_INCLUDED
+#define DMC_CC_INCDIRS_HPP_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include "file_util.hpp"
+
+class IncDirCache {
+public:
+    IncDirCache() : loaded_(false) {}
+    ~IncDirCache() { save(); }
+
+    void set_path(std::string const& path) { path_ = path; }
+
+    /// USED of key, if its files are as they were.
+    bool find(std::string const& key, std::string& used) {
+        load();
+        entry_map::const_iterator it = entries_.find(key);
+        if (it == entries_.end())
+            return false;
+        Entry const& e = it->second;
+        for (std::size_t i = 0; i < e.files.size(); ++i) {
+            unsigned long long size, mtime;
+            stamp(e.files[i], size, mtime);
+            if (size != e.sizes[i] || mtime != e.mtimes[i])
+                return false;
+        }
+        used = e.used;
+        return true;
+    }
+
+    /// Record used for key, with the current size and mtime of files.
+    void add(std::string const& key, std::string const& used, std::vector<std::string> const& files) {
+        load();
+        Entry& e = entries_[key];
+        e.used = used;
+        e.files.clear();
+        e.sizes.clear();
+        e.mtimes.clear();
+        char buf[64];
+        pending_ += key + "\t" + used;
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            unsigned long long size, mtime;
+            stamp(files[i], size, mtime);
+            e.files.push_back(files[i]);
+            e.sizes.push_back(size);
+            e.mtimes.push_back(mtime);
+            std::sprintf(buf, "\t%llu\t%llu", size, mtime);
+            pending_ += "\t" + files[i] + buf;
+        }
+        pending_ += "\n";
+    }
+
+    /// Append the new lines to the file.
+    void save() {
+        if (path_.empty() || pending_.empty())
+            return;
+        std::string dir = path_.substr(0, path_.find_last_of("/\\") + 1);
+        if (dir.empty() || zatu::file_util::make_dirs(dir))
+            zatu::file_util::file_append(path_.c_str(), pending_);
+        pending_.clear();
+    }
+
+private:
+    struct Entry {
+        std::string                     used;
+        std::vector<std::string>        files;
+        std::vector<unsigned long long> sizes;
+        std::vector<unsigned long long> mtimes;
+    };
+    typedef std::map<std::string, Entry>    entry_map;
+
+    /// size and mtime of path. (0, 0: none)
+    static void stamp(std::string const& path, unsigned long long& size, unsigned long long& mtime) {
+        zatu::file_util::file_stat_t st;
+        if (!zatu::file_util::file_stat(path.c_str(), st)) {
+            size  = 0;
+            mtime = 0;
+            return;
+        }
+        size  = st.is_dir ? 0 : st.size;    // the size of a directory varies by file system.
+        mtime = st.mtime;
+    }
+
+    /// Load the file. Rewrite it when most of its lines are stale.
+    void load() {
+        if (loaded_ || path_.empty())
+            return;
+        loaded_ = true;
+        std::string text;
+        if (!zatu::file_util::file_read(path_.c_str(), text))
+            return;
+        std::size_t lines = 0;
+        std::size_t pos   = 0;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;      // a line being appended.
+            std::vector<std::string> f;
+            split(text.substr(pos, eol - pos), f);
+            pos = eol + 1;
+            ++lines;
+            if (f.size() < 2 || f.size() % 3 != 2)
+                continue;
+            Entry& e = entries_[f[0]];
+            e.used = f[1];
+            e.files.clear();
+            e.sizes.clear();
+            e.mtimes.clear();
+            for (std::size_t i = 2; i < f.size(); i += 3) {
+                unsigned long long size = 0, mtime = 0;
+                std::sscanf(f[i + 1].c_str(), "%llu", &size);
+                std::sscanf(f[i + 2].c_str(), "%llu", &mtime);
+                e.files.push_back(f[i]);
+                e.sizes.push_back(size);
+                e.mtimes.push_back(mtime);
+            }
+        }
+        if (lines > 1024 && entries_.size() * 2 < lines)
+            compact();
+    }
+
+    void compact() {
+        std::string s;
+        char        buf[64];
+        for (entry_map::const_iterator it = entries_.begin(); it != entries_.end(); ++it) {
+            Entry const& e = it->second;
+            s += it->first + "\t" + e.used;
+            for (std::size_t i = 0; i < e.files.size(); ++i) {
+                std::sprintf(buf, "\t%llu\t%llu", e.sizes[i], e.mtimes[i]);
+                s += "\t" + e.files[i] + buf;
+            }
+            s += "\n";
+        }
+        zatu::file_util::file_save_atomic(path_.c_str(), s);
+    }
+
+    static void split(std::string const& line, std::vector<std::string>& f) {
+        std::size_t b = 0;
+        for (;;) {
+            std::size_t t = line.find('\t', b);
+            f.push_back(line.substr(b, t - b));
+            if (t == std::string::npos)
+                break;
+            b = t + 1;
+        }
+    }
+
+private:
+    std::string     path_;
+    std::string     pending_;
+    entry_map       entries_;
+    bool            loaded_;
+};
+
+#endif  // DMC_CC_INCDIRS_HPP_INCLUDED
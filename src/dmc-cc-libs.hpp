@@ -0,0 +1,153 @@
+/**
+ *  @file   dmc-cc-libs.hpp
+ *  @brief  Index of the .lib files in the library directories, for -l of dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    -lNAME is searched as libNAME.lib then NAME.lib in each directory in order,
+ *    like gcc does libNAME.a. Names are compared case-insensitively.
+ *    NAME.lib.dmc-ar (a member list of dmc-ar, the .lib may not be made yet) counts as NAME.lib.
+ *    The listing of each directory is cached and reused while its mtime is the same:
+ *      D \t MTIME \t DIR
+ *      \t NAME.lib         (one line per file)
+ */
+#ifndef DMC_CC_LIBS_HPP_INCLUDED
+#define DMC_CC_LIBS_HPP_INCLUDED
+
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <map>
+#include "file_util.hpp"
+
+class LibIndex {
+public:
+    LibIndex() : loaded_(false), dirty_(false) {}
+
+    void set_cache_path(std::string const& path) { cache_path_ = path; }
+
+    /// Absolute path of -lNAME in dirs, or "" if not found.
+    std::string resolve(std::string const& name, std::vector<std::string> const& dirs) {
+        std::string a = lower("lib" + name + ".lib");
+        std::string b = lower(name + ".lib");
+        for (std::size_t i = 0; i < dirs.size(); ++i) {
+            Dir const& d = dir(dirs[i]);
+            for (std::size_t k = 0; k < d.names.size(); ++k) {
+                if (lower(d.names[k]) == a)
+                    return zatu::file_util::path_join(d.path, d.names[k]);
+            }
+            for (std::size_t k = 0; k < d.names.size(); ++k) {
+                if (lower(d.names[k]) == b)
+                    return zatu::file_util::path_join(d.path, d.names[k]);
+            }
+        }
+        return std::string();
+    }
+
+    /// Write the cache if a listing was updated.
+    bool save() {
+        if (!dirty_ || cache_path_.empty())
+            return true;
+        char        buf[64];
+        std::string s;
+        for (dir_map::const_iterator it = dirs_.begin(); it != dirs_.end(); ++it) {
+            Dir const& d = it->second;
+            if (!d.exist)
+                continue;
+            std::sprintf(buf, "D\t%llu\t", d.mtime);
+            s += buf + it->first + "\n";
+            for (std::size_t k = 0; k < d.names.size(); ++k)
+                s += "\t" + d.names[k] + "\n";
+        }
+        std::string dir = cache_path_.substr(0, cache_path_.find_last_of("/\\") + 1);
+        if (!dir.empty() && !zatu::file_util::make_dirs(dir))
+            return false;
+        dirty_ = false;
+        return zatu::file_util::file_save_atomic(cache_path_.c_str(), s);
+    }
+
+private:
+    struct Dir {
+        std::string                 path;       // absolute.
+        unsigned long long          mtime;
+        bool                        exist;
+        bool                        checked;    // compared with the directory in this run.
+        std::vector<std::string>    names;      // *.lib, and * of *.lib.dmc-ar
+        Dir() : mtime(0), exist(false), checked(false) {}
+    };
+    typedef std::map<std::string, Dir>  dir_map;
+
+    Dir const& dir(std::string const& name) {
+        load();
+        std::string path = zatu::file_util::full_path(name);
+        Dir&        d    = dirs_[path];
+        if (d.checked)
+            return d;
+        d.checked = true;
+        d.path    = path;
+        zatu::file_util::file_stat_t st;
+        bool exist = zatu::file_util::file_stat(path.c_str(), st) && st.is_dir;
+        if (exist == d.exist && (!exist || st.mtime == d.mtime))
+            return d;
+        d.exist = exist;
+        d.mtime = st.mtime;
+        d.names.clear();
+        std::vector<std::string> names;
+        if (exist && zatu::file_util::list_dir(path, names)) {
+            for (std::size_t k = 0; k < names.size(); ++k) {
+                std::string const& n = names[k];
+                if (n.size() > 4 && lower(n.substr(n.size() - 4)) == ".lib")
+                    d.names.push_back(n);
+                else if (n.size() > 11 && lower(n.substr(n.size() - 11)) == ".lib.dmc-ar")
+                    d.names.push_back(n.substr(0, n.size() - 7));
+            }
+        }
+        dirty_ = true;
+        return d;
+    }
+
+    void load() {
+        if (loaded_)
+            return;
+        loaded_ = true;
+        std::string text;
+        if (cache_path_.empty() || !zatu::file_util::file_read(cache_path_.c_str(), text))
+            return;
+        Dir*        d   = NULL;
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;
+            std::string line = text.substr(pos, eol - pos);
+            pos = eol + 1;
+            if (line.compare(0, 2, "D\t") == 0) {
+                std::size_t t = line.find('\t', 2);
+                if (t == std::string::npos)
+                    continue;
+                d = &dirs_[line.substr(t + 1)];
+                d->path  = line.substr(t + 1);
+                d->exist = true;
+                std::sscanf(line.c_str() + 2, "%llu", &d->mtime);
+            } else if (d && line.size() > 1 && line[0] == '\t') {
+                d->names.push_back(line.substr(1));
+            }
+        }
+    }
+
+    static std::string lower(std::string s) {
+        for (std::size_t i = 0; i < s.size(); ++i)
+            s[i] = char(std::tolower((unsigned char)s[i]));
+        return s;
+    }
+
+private:
+    std::string     cache_path_;
+    dir_map         dirs_;
+    bool            loaded_;
+    bool            dirty_;
+};
+
+#endif  // DMC_CC_LIBS_HPP_INCLUDED
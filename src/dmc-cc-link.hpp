@@ -0,0 +1,146 @@
+/**
+ *  @file   dmc-cc-link.hpp
+ *  @brief  Link manifest of dmc-cc, to skip a link whose inputs are unchanged.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    OUT.dmc-cc-link, written after a successful link of OUT:
+ *      dmc-cc link 1
+ *      K   KEY                     hash of the link arguments and the input hashes.
+ *      O   SIZE MTIME              OUT itself.
+ *      F   SIZE MTIME HASH PATH    each input.
+ *    The content hash of an input is reused while its size and mtime are unchanged.
+ */
+#ifndef DMC_CC_LINK_HPP_INCLUDED
+#define DMC_CC_LINK_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include "file_util.hpp"
+#include "hash_util.hpp"
+
+class LinkManifest {
+public:
+    explicit LinkManifest(std::string const& out) : out_(out), path_(out + ".dmc-cc-link") {}
+
+    std::string const& path() const { return path_; }
+
+    /** Make the key of args (NULL terminated) and inputs.
+     *  @return true if it is the key of the last link and OUT is the one it made.
+     */
+    bool up_to_date(char const* const* args, std::vector<std::string> const& inputs) {
+        std::string              old_key;
+        unsigned long long       out_size = 0, out_mtime = 0;
+        std::map<std::string, Entry> old;
+        load(old_key, out_size, out_mtime, old);
+
+        zatu::hash_util::fnv1a64 h;
+        h.add("dmc-cc link 1");
+        for (std::size_t i = 0; args[i]; ++i)
+            h.add(args[i]);
+        entries_.clear();
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            Entry e;
+            e.path = inputs[i];
+            zatu::file_util::file_stat_t st;
+            if (zatu::file_util::file_stat(e.path.c_str(), st)) {
+                e.size  = st.size;
+                e.mtime = st.mtime;
+                std::map<std::string, Entry>::const_iterator it = old.find(e.path);
+                if (it != old.end() && it->second.size == e.size && it->second.mtime == e.mtime)
+                    e.hash = it->second.hash;
+                else
+                    e.hash = file_hash(e.path);
+            }
+            h.add(e.path).add(e.hash);
+            entries_.push_back(e);
+        }
+        key_ = h.hex();
+
+        zatu::file_util::file_stat_t st;
+        return key_ == old_key && zatu::file_util::file_stat(out_.c_str(), st)
+            && st.size == out_size && st.mtime == out_mtime;
+    }
+
+    /// Record the key of up_to_date() for the OUT just linked.
+    bool save() const {
+        zatu::file_util::file_stat_t st;
+        if (key_.empty() || !zatu::file_util::file_stat(out_.c_str(), st))
+            return false;
+        char        buf[128];
+        std::string s = "dmc-cc link 1\nK\t" + key_ + "\n";
+        std::sprintf(buf, "O\t%llu\t%llu\n", st.size, st.mtime);
+        s += buf;
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            Entry const& e = entries_[i];
+            std::sprintf(buf, "F\t%llu\t%llu\t", e.size, e.mtime);
+            s += buf + e.hash + "\t" + e.path + "\n";
+        }
+        return zatu::file_util::file_save_atomic(path_.c_str(), s);
+    }
+
+    /// Forget the last link, e.g. when it failed.
+    void clear() const { std::remove(path_.c_str()); }
+
+private:
+    struct Entry {
+        std::string         path;
+        std::string         hash;       // "" if it does not exist.
+        unsigned long long  size;
+        unsigned long long  mtime;
+        Entry() : size(0), mtime(0) {}
+    };
+
+    static std::string file_hash(std::string const& path) {
+        zatu::file_util::mapped_file mf(path.c_str());
+        if (!mf.is_open())
+            return std::string();
+        return zatu::hash_util::fnv1a64().add(mf.begin(), mf.size()).hex();
+    }
+
+    bool load(std::string& key, unsigned long long& size, unsigned long long& mtime
+              , std::map<std::string, Entry>& entries) const
+    {
+        std::string text;
+        if (!zatu::file_util::file_read(path_.c_str(), text) || text.compare(0, 14, "dmc-cc link 1\n") != 0)
+            return false;
+        std::size_t pos = 14;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;
+            std::string line = text.substr(pos, eol - pos);
+            pos = eol + 1;
+            if (line.compare(0, 2, "K\t") == 0) {
+                key = line.substr(2);
+            } else if (line.compare(0, 2, "O\t") == 0) {
+                std::sscanf(line.c_str() + 2, "%llu\t%llu", &size, &mtime);
+            } else if (line.compare(0, 2, "F\t") == 0) {
+                Entry e;
+                int   n = 0;
+                if (std::sscanf(line.c_str() + 2, "%llu\t%llu\t%n", &e.size, &e.mtime, &n) != 2 || n == 0)
+                    continue;
+                std::size_t h = 2 + n;
+                std::size_t t = line.find('\t', h);
+                if (t == std::string::npos)
+                    continue;
+                e.hash = line.substr(h, t - h);
+                e.path = line.substr(t + 1);
+                entries[e.path] = e;
+            }
+        }
+        return !key.empty();
+    }
+
+private:
+    std::string         out_;
+    std::string         path_;
+    std::string         key_;
+    std::vector<Entry>  entries_;
+};
+
+#endif  // DMC_CC_LINK_HPP_INCLUDED
@@ -0,0 +1,252 @@
+/**
+ *  @file   dmc-cc-opts.hpp
+ *  @brief  gcc -> dmc option table of dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    The option dispatch, --help and the README usage are all made from opt_defs[].
+ *    Each argument is looked up by one walk of a prefix trie, so the cost per
+ *    argument does not depend on the number of options.
+ */
+#ifndef DMC_CC_OPTS_HPP_INCLUDED
+#define DMC_CC_OPTS_HPP_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+/// Option mode.
+enum {
+    M_GCC       = 1,
+    M_NATIVE    = 2,
+    M_ALL       = 3,
+};
+
+/// How the value of an option is taken.
+enum {
+    K_FLAG,         // -X           exact match.
+    K_JOINED,       // -XVALUE -X=VALUE
+    K_ARG,          // -XVALUE -X=VALUE -X VALUE
+    K_BOOL,         // -X (true) -X- (false)
+};
+
+/// What an option does.
+enum {
+    A_OPT,          // add dmc + value. (dmc == NULL: add the argument as is)
+    A_OPT_BSL,      // add dmc + value with '/' -> '\'
+    A_NONE,         // accept and ignore.
+    A_COMPILE,      // -c
+    A_OUTPUT,       // -oFILE
+    A_LIB,          // libNAME.lib
+    A_STD_CXX,      // add dmc, C++ mode.
+    A_STD_C,        // C mode.
+    A_VERBOSE,      // add dmc, verbose on.
+    A_QUIET,        // add dmc, verbose off.
+    A_STACK_CHECK,  // add dmc unless value is "no".
+    A_LINKER,       // -L[LINKER]
+    A_HELP,
+    A_GCC,
+    A_NATIVE,
+    A_PRINT_ARGS,
+    A_JOBS,
+    A_UNITY,
+    A_WORKERS,
+    A_TOOLCHAIN,
+    A_CC_LINKER,
+    A_UNITY_EXCLUDE,
+    A_CACHE,
+    A_CACHE_STATS,
+    A_TRACE,
+    A_STATS,
+    A_NATIVE_DIAG,
+    A_PRUNE_INC,
+    A_WATCH,
+    A_DEP,          // -MD
+    A_DEP_USER,     // -MMD
+    A_DEP_FILE,     // -MF FILE
+    A_DEP_TARGET,   // -MT TARGET
+    A_DEP_QUOTE,    // -MQ TARGET
+    A_DEP_PHONY,    // -MP
+    A_FIRST_ARG,    // only valid as argv[1]. (handled before translation)
+};
+
+struct OptDef {
+    unsigned char   mode;
+    unsigned char   kind;
+    unsigned char   act;
+    char const*     name;       // NULL: help line only.
+    char const*     dmc;
+    char const*     help;       // NULL: not listed.
+    char const*     help2;      // dmc column, or description.
+};
+
+static OptDef const opt_defs[] = {
+    // mode   kind      act             name                    dmc         help                        help2
+    { M_ALL,  K_FLAG,   A_HELP,         "--help",               NULL,       "--help",                   "Help." },
+    { M_ALL,  K_FLAG,   A_NATIVE,       "--NATIVE",             NULL,       "--NATIVE",                 "Afterwards dmc option." },
+    { M_ALL,  K_FLAG,   A_NATIVE,       "--DMC",                NULL,       NULL,                       NULL },
+    { M_ALL,  K_FLAG,   A_GCC,          "--GCC",                NULL,       "--GCC",                    "Afterwards gcc option." },
+    { M_ALL,  K_BOOL,   A_PRINT_ARGS,   "--CC-print-args",      NULL,       NULL,                       NULL },
+    { M_ALL,  K_ARG,    A_JOBS,         "--CC-jobs",            NULL,       "--CC-jobs=N",              "Compile each source by N parallel dmc processes. (0:cpus)" },
+    { M_ALL,  K_ARG,    A_TOOLCHAIN,    "--CC-toolchain",       NULL,       "--CC-toolchain=NAME",      "Use toolchain NAME of dmc-cc-toolchains.ini. (or DMC_CC_TOOLCHAIN)" },
+    { M_ALL,  K_ARG,    A_CC_LINKER,    "--CC-linker",          NULL,       "--CC-linker=L",            "Linker: optlink, link, wlink or a path." },
+    { M_ALL,  K_ARG,    A_UNITY,        "--CC-unity",           NULL,       "--CC-unity=K",             "Link: compile sources K at a time as one unity TU." },
+    { M_ALL,  K_ARG,    A_UNITY_EXCLUDE,"--CC-unity-exclude",   NULL,       "--CC-unity-exclude=FILE",  "Compile FILE by itself in --CC-unity." },
+    { M_ALL,  K_ARG,    A_CACHE,        "--CC-cache",           NULL,       "--CC-cache=DIR",           "Object cache directory. (or DMC_CC_CACHE_DIR)" },
+    { M_ALL,  K_FLAG,   A_CACHE_STATS,  "--CC-cache-stats",     NULL,       "--CC-cache-stats",         "Print cache hit/miss counts." },
+    { M_ALL,  K_FLAG,   A_NATIVE_DIAG,  "--CC-native-diag",     NULL,       "--CC-native-diag",         "Print dmc diagnostics as they are. (not gcc form)" },
+    { M_ALL,  K_FLAG,   A_PRUNE_INC,    "--CC-prune-includes",  NULL,       "--CC-prune-includes",      "Pass each source only the -I it finds headers through." },
+    { M_ALL,  K_FLAG,   A_WATCH,        "--CC-watch",           NULL,       "--CC-watch",               "Build, then rebuild the sources affected by each change." },
+    { M_ALL,  K_FLAG,   A_STATS,        "--CC-stats",           NULL,       "--CC-stats",               "Rank slow/large TUs from the resource log." },
+    { M_ALL,  K_ARG,    A_TRACE,        "--CC-trace",           NULL,       "--CC-trace=FILE",          "Append Chrome trace events to FILE. (or DMC_CC_TRACE)" },
+    { M_ALL,  K_FLAG,   A_FIRST_ARG,    "--CC-ar",              NULL,       "--CC-ar ARGS",             "Run as ar by lib.exe. (as dmc-ar does)" },
+    { M_ALL,  K_JOINED, A_FIRST_ARG,    "--CC-server",          NULL,       "--CC-server[=[HOST:]PORT]","Run as translation server. (or DMC_CC_SERVER)" },
+    { M_ALL,  K_FLAG,   A_FIRST_ARG,    "--CC-server-stop",     NULL,       "--CC-server-stop",         "Stop the server." },
+    { M_ALL,  K_ARG,    A_WORKERS,      "--CC-workers",         NULL,       "--CC-workers=H:P,..",      "Compile on --CC-worker hosts. (or DMC_CC_WORKERS)" },
+    { M_ALL,  K_JOINED, A_FIRST_ARG,    "--CC-worker",          NULL,       "--CC-worker[=[HOST:]PORT]","Run as compile worker." },
+    { M_ALL,  K_JOINED, A_FIRST_ARG,    "--CC-worker-stop",     NULL,       "--CC-worker-stop[=[HOST:]PORT]", "Stop the worker." },
+
+    { M_GCC,  K_ARG,    A_OPT,          "--define-macro",       "-D",       "--define-macro M[=S]",     "-D[M[=S]]" },
+    { M_GCC,  K_JOINED, A_OPT,          "-D",                   "-D",       "-D[MACRO[=STR]]",          "-D[MACRO[=STR]]" },
+    { M_GCC,  K_ARG,    A_OPT,          "--undefine-macro",     "-U",       "--undefine-macro MACRO",   "-U[MACRO]" },
+    { M_GCC,  K_JOINED, A_OPT,          "-U",                   "-U",       "-U[MACRO]",                "-U[MACRO]" },
+    { M_GCC,  K_ARG,    A_OPT,          "--include-directory",  "-I",       "--include-directory DIR",  "-I[DIR]" },
+    { M_GCC,  K_ARG,    A_OPT,          "-I",                   "-I",       "-I DIR",                   "-I[DIR]" },
+    { M_GCC,  K_ARG,    A_OPT,          "--include",            "-HI",      "--include FILE",           "-HI[FILE]" },
+    { M_GCC,  K_FLAG,   A_COMPILE,      "-c",                   NULL,       NULL,                       NULL },
+    { M_GCC,  K_FLAG,   A_DEP,          "-MD",                  NULL,       "-MD",                      "(write OBJ.d)" },
+    { M_GCC,  K_FLAG,   A_DEP_USER,     "-MMD",                 NULL,       "-MMD",                     "(write OBJ.d without system headers)" },
+    { M_GCC,  K_ARG,    A_DEP_FILE,     "-MF",                  NULL,       "-MF FILE",                 "(.d file name)" },
+    { M_GCC,  K_ARG,    A_DEP_TARGET,   "-MT",                  NULL,       "-MT TARGET",               "(.d target)" },
+    { M_GCC,  K_ARG,    A_DEP_QUOTE,    "-MQ",                  NULL,       "-MQ TARGET",               "(.d target, quoted)" },
+    { M_GCC,  K_FLAG,   A_DEP_PHONY,    "-MP",                  NULL,       "-MP",                      "(.d phony header targets)" },
+    { M_GCC,  K_ARG,    A_OUTPUT,       "--output",             NULL,       "--output FILE",            "-o[FILE]" },
+    { M_GCC,  K_ARG,    A_OUTPUT,       "-o",                   NULL,       "-o FILE",                  "-o[FILE]" },
+    { M_GCC,  K_ARG,    A_LIB,          "--library",            NULL,       "--library NAME",           "lib[NAME].lib" },
+    { M_GCC,  K_ARG,    A_LIB,          "-l",                   NULL,       "-l NAME",                  "lib[NAME].lib" },
+    { M_GCC,  K_ARG,    A_OPT_BSL,      "--library-path",       "-L/",      "--library-path DIR",       "-L/DIR" },
+    { M_GCC,  K_ARG,    A_OPT_BSL,      "-L",                   "-L/",      "-L DIR",                   "-L/DIR" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-S",                   "-cod",     "-S",                       "-cod" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-shared",              "-WD",      "-shared",                  "-WD" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-mdll",                "-WD",      "-mdll",                    "-WD" },
+    { M_GCC,  K_FLAG,   A_OPT,          "--debug",              "-g",       "--debug",                  "-g" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-g",                   "-g",       "-g",                       "-g" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-Wall",                "-w",       "-Wall",                    "-w" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-Werror",              "-wx",      "-Werror",                  "-wx" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-O0",                  "-o+none",  "-O0",                      "-o+none" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-O1",                  "-o+all",   "-O1 -O2 -O3",              "-o+all" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-O2",                  "-o+all",   NULL,                       NULL },
+    { M_GCC,  K_FLAG,   A_OPT,          "-O3",                  "-o+all",   NULL,                       NULL },
+    { M_GCC,  K_FLAG,   A_OPT,          "-Ofast",               "-o+speed", "-Ofast",                   "-o+speed" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-Os",                  "-o+space", "-Os",                      "-o+space" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-Oz",                  "-o+space", "-Oz",                      "-o+space" },
+    { M_GCC,  K_JOINED, A_STD_CXX,      "--std=c++",            "-cpp",     "--std=c++??",              "-cpp" },
+    { M_GCC,  K_JOINED, A_STD_CXX,      "--std=gnu++",          "-cpp",     "--std=gnu++??",            "-cpp" },
+    { M_GCC,  K_JOINED, A_STD_C,        "--std=c",              NULL,       "--std=c??",                "" },
+    { M_GCC,  K_JOINED, A_STD_C,        "--std=gnu",            NULL,       "--std=gnu??",              "" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-frtti",               "-Ar",      "-frtti",                   "-Ar" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-fexceptions",         "-Ae",      "-fexceptions",             "-Ae" },
+    { M_GCC,  K_FLAG,   A_OPT,          "-funsigned-char",      "-J",       "-funsigned-char",          "-J" },
+    { M_GCC,  K_FLAG,   A_NONE,         "-fsigned-char",        NULL,       "-fsigned-char",            "" },
+    { M_GCC,  K_JOINED, A_STACK_CHECK,  "-fstack-check",        "-s",       "-fstack-check-generic",    "-s" },
+    { M_GCC,  K_FLAG,   A_NONE,         NULL,                   NULL,       "-fstack-check-specific",   "-s" },
+    { M_GCC,  K_FLAG,   A_OPT,          "--ansi",               "-A",       "--ansi",                   "-A" },
+    { M_GCC,  K_FLAG,   A_VERBOSE,      "-v",                   "-v1",      "-v",                       "-v1" },
+    { M_GCC,  K_FLAG,   A_VERBOSE,      "--verbose",            "-v1",      NULL,                       NULL },
+    { M_GCC,  K_FLAG,   A_VERBOSE,      "-v2",                  "-v2",      NULL,                       NULL },
+
+    { M_NATIVE, K_JOINED, A_OPT,        "-o+",                  "-o+",      NULL,                       NULL },
+    { M_NATIVE, K_JOINED, A_OPT,        "-o-",                  "-o-",      NULL,                       NULL },
+    { M_NATIVE, K_JOINED, A_OUTPUT,     "-o",                   NULL,       NULL,                       NULL },
+    { M_NATIVE, K_FLAG,   A_COMPILE,    "-c",                   NULL,       NULL,                       NULL },
+    { M_NATIVE, K_JOINED, A_OPT,        "-I",                   "-I",       NULL,                       NULL },
+    { M_NATIVE, K_JOINED, A_OPT,        "-L/",                  "-L/",      NULL,                       NULL },
+    { M_NATIVE, K_JOINED, A_LINKER,     "-L",                   "-L",       NULL,                       NULL },
+    { M_NATIVE, K_FLAG,   A_QUIET,      "-v0",                  "-v0",      NULL,                       NULL },
+    { M_NATIVE, K_FLAG,   A_VERBOSE,    "-v1",                  NULL,       NULL,                       NULL },
+    { M_NATIVE, K_FLAG,   A_VERBOSE,    "-v2",                  NULL,       NULL,                       NULL },
+};
+
+/// Prefix trie of opt_defs[].name for one mode.
+class OptTrie {
+    struct Node {
+        int     child;
+        int     next;
+        int     def;
+        char    ch;
+    };
+
+public:
+    explicit OptTrie(unsigned mode) {
+        Node root = { -1, -1, -1, 0 };
+        nodes_.push_back(root);
+        for (size_t i = 0; i < sizeof(opt_defs) / sizeof(opt_defs[0]); ++i) {
+            if (opt_defs[i].name && (opt_defs[i].mode & mode))
+                add(opt_defs[i].name, int(i));
+        }
+    }
+
+    /// Longest option that matches the head of arg. (NULL: unknown option)
+    OptDef const* find(char const* arg) const {
+        int best = -1;
+        int n    = 0;
+        for (char const* a = arg; *a; ++a) {
+            int c = nodes_[n].child;
+            while (c >= 0 && nodes_[c].ch != *a)
+                c = nodes_[c].next;
+            if (c < 0)
+                break;
+            n = c;
+            int d = nodes_[n].def;
+            if (d >= 0 && (opt_defs[d].kind != K_FLAG || a[1] == 0))
+                best = d;
+        }
+        return (best >= 0) ? &opt_defs[best] : NULL;
+    }
+
+private:
+    void add(char const* name, int def) {
+        int n = 0;
+        for (char const* a = name; *a; ++a) {
+            int c = nodes_[n].child;
+            while (c >= 0 && nodes_[c].ch != *a)
+                c = nodes_[c].next;
+            if (c < 0) {
+                Node nd = { -1, nodes_[n].child, -1, *a };
+                c = int(nodes_.size());
+                nodes_.push_back(nd);
+                nodes_[n].child = c;
+            }
+            n = c;
+        }
+        if (nodes_[n].def < 0)
+            nodes_[n].def = def;
+    }
+
+private:
+    std::vector<Node>   nodes_;
+};
+
+inline OptDef const* find_opt(char const* arg, unsigned mode) {
+    static OptTrie const gcc_trie(M_GCC);
+    static OptTrie const native_trie(M_NATIVE);
+    return (mode == M_NATIVE) ? native_trie.find(arg) : gcc_trie.find(arg);
+}
+
+/// Option lines of --help.
+inline void print_opt_help(FILE* fp) {
+    size_t const n = sizeof(opt_defs) / sizeof(opt_defs[0]);
+    for (size_t i = 0; i < n; ++i) {
+        OptDef const& d = opt_defs[i];
+        if (d.help && d.mode == M_ALL)
+            std::fprintf(fp, "  %-8s  %s\n", d.help, d.help2);
+    }
+    std::fprintf(fp, " (gcc)                   (dmc)\n");
+    for (size_t i = 0; i < n; ++i) {
+        OptDef const& d = opt_defs[i];
+        if (d.help && d.mode == M_GCC)
+            std::fprintf(fp, "  %-23s %s\n", d.help, d.help2);
+    }
+}
+
+#endif  // DMC_CC_OPTS_HPP_INCLUDED
@@ -0,0 +1,60 @@
+/**
+ *  @file   dmc-cc-probe.hpp
+ *  @brief  Results of the CMake compiler probes, replayed by dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    STATE_DIR/probe/TOOLCHAIN/KEY.txt   "RC HAS_OUTPUT\n" + the printed text
+ *    STATE_DIR/probe/TOOLCHAIN/KEY.bin   the output file (.obj or .exe)
+ *    TOOLCHAIN is the hash of the dmc.exe and dmc-cc stamps, so a new dmc starts
+ *    with an empty store. .txt is written last, so a half written entry is not used.
+ */
+#ifndef DMC_CC_PROBE_HPP_INCLUDED
+#define DMC_CC_PROBE_HPP_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include "file_util.hpp"
+
+class ProbeCache {
+public:
+    void set_dir(std::string const& dir) { dir_ = dir; }
+
+    /// Restore the result of key: out is written, text and rc are set.
+    bool get(std::string const& key, std::string const& out, std::string& text, int& rc) const {
+        std::string s;
+        if (!zatu::file_util::file_read(path(key, ".txt").c_str(), s))
+            return false;
+        std::size_t eol = s.find('\n');
+        int         has = 0;
+        if (eol == std::string::npos || std::sscanf(s.c_str(), "%d %d", &rc, &has) != 2)
+            return false;
+        if (has && !zatu::file_util::file_copy(path(key, ".bin").c_str(), out.c_str()))
+            return false;
+        text = s.substr(eol + 1);
+        return true;
+    }
+
+    /// Keep the result of key. out is kept if it exists.
+    bool put(std::string const& key, std::string const& out, std::string const& text, int rc) const {
+        if (!zatu::file_util::make_dirs(dir_))
+            return false;
+        zatu::file_util::file_stat_t st;
+        bool has = !out.empty() && zatu::file_util::file_stat(out.c_str(), st) && !st.is_dir
+                && zatu::file_util::file_copy(out.c_str(), path(key, ".bin").c_str());
+        char buf[32];
+        std::sprintf(buf, "%d %d\n", rc, int(has));
+        return zatu::file_util::file_save_atomic(path(key, ".txt").c_str(), buf + text);
+    }
+
+private:
+    std::string path(std::string const& key, char const* ext) const {
+        return zatu::file_util::path_join(dir_, key + ext);
+    }
+
+private:
+    std::string     dir_;
+};
+
+#endif  // DMC_CC_PROBE_HPP_INCLUDED
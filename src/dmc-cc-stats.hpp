@@ -0,0 +1,202 @@
+/**
+ *  @file   dmc-cc-stats.hpp
+ *  @brief  Per child resource log of dmc-cc, and the --CC-stats report.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    One JSON object per line, appended by one write: (STATE_DIR/stats.jsonl)
+ *      {"ts":..,"kind":"compile","src":"a.c","obj":"a.obj","args":"HASH","rc":0,
+ *       "wall_ms":..,"user_ms":..,"sys_ms":..,"rss_kb":..}
+ *    args is the hash of the translated options, so that TUs of one target group.
+ *    The log is renamed to *.old when it exceeds 32MB.
+ */
+#ifndef DMC_CC_STATS_HPP_INCLUDED
+#define DMC_CC_STATS_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "file_util.hpp"
+#include "dmc-cc-trace.hpp"
+
+struct StatRec {
+    std::string         kind;       // compile, dmc, link
+    std::string         src;
+    std::string         obj;
+    std::string         args;
+    int                 rc;
+    double              wall_ms;
+    double              user_ms;
+    double              sys_ms;
+    unsigned long long  rss_kb;
+    StatRec() : rc(0), wall_ms(0), user_ms(0), sys_ms(0), rss_kb(0) {}
+};
+
+class StatsLog {
+public:
+    enum { MAX_SIZE = 32 * 1024 * 1024 };
+
+    void set_path(std::string const& path) { path_ = path; }
+
+    std::string const& path() const { return path_; }
+
+    bool append(StatRec const& r) const {
+        if (path_.empty())
+            return false;
+        std::string dir = path_.substr(0, path_.find_last_of("/\\") + 1);
+        if (!dir.empty() && !zatu::file_util::make_dirs(dir))
+            return false;
+        zatu::file_util::file_stat_t st;
+        if (zatu::file_util::file_stat(path_.c_str(), st) && st.size > MAX_SIZE)
+            zatu::file_util::file_rename(path_.c_str(), (path_ + ".old").c_str());
+        char buf[256];
+        std::string s;
+        std::sprintf(buf, "{\"ts\":%llu,\"kind\":\"", Tracer::now());
+        s += buf;
+        json_escape(s, r.kind);
+        s += "\",\"src\":\"";
+        json_escape(s, r.src);
+        s += "\",\"obj\":\"";
+        json_escape(s, r.obj);
+        s += "\",\"args\":\"";
+        json_escape(s, r.args);
+        std::sprintf(buf, "\",\"rc\":%d,\"wall_ms\":%.1f,\"user_ms\":%.1f,\"sys_ms\":%.1f,\"rss_kb\":%llu}\n"
+                     , r.rc, r.wall_ms, r.user_ms, r.sys_ms, r.rss_kb);
+        s += buf;
+        return zatu::file_util::file_append(path_.c_str(), s);
+    }
+
+    /// Rank the slowest sources, the largest ones and the option sets with the most varying time.
+    int report(FILE* fp, std::size_t top = 10) const {
+        std::string text;
+        if (!zatu::file_util::file_read(path_.c_str(), text)) {
+            std::fprintf(stderr, "no stats log %s\n", path_.c_str());
+            return 1;
+        }
+        agg_map by_src, by_args;
+        std::size_t recs = 0;
+        std::size_t pos  = 0;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                break;
+            StatRec r;
+            if (parse(text.substr(pos, eol - pos), r) && r.kind != "link") {
+                ++recs;
+                by_src[r.src].add(r, r.src);
+                by_args[r.args].add(r, r.src);
+            }
+            pos = eol + 1;
+        }
+        std::fprintf(fp, "%u compiles, %u sources, %u option sets. (%s)\n"
+                     , unsigned(recs), unsigned(by_src.size()), unsigned(by_args.size()), path_.c_str());
+
+        std::vector<rank_t> v;
+        for (agg_map::const_iterator it = by_src.begin(); it != by_src.end(); ++it)
+            v.push_back(rank_t(it->second.sum / it->second.n, &*it));
+        print_top(fp, "slowest sources", "mean ms", v, top);
+
+        v.clear();
+        for (agg_map::const_iterator it = by_src.begin(); it != by_src.end(); ++it)
+            v.push_back(rank_t(double(it->second.max_rss), &*it));
+        print_top(fp, "largest peak memory", "KB", v, top);
+
+        v.clear();
+        for (agg_map::const_iterator it = by_args.begin(); it != by_args.end(); ++it) {
+            if (it->second.n > 1)
+                v.push_back(rank_t(it->second.stddev(), &*it));
+        }
+        print_top(fp, "option sets by wall time variance", "stddev ms", v, top);
+        return 0;
+    }
+
+private:
+    struct Agg {
+        std::size_t         n;
+        double              sum;
+        double              sum2;
+        unsigned long long  max_rss;
+        std::string         src;        // an example source.
+        Agg() : n(0), sum(0), sum2(0), max_rss(0) {}
+        void add(StatRec const& r, std::string const& s) {
+            ++n;
+            sum  += r.wall_ms;
+            sum2 += r.wall_ms * r.wall_ms;
+            if (max_rss < r.rss_kb)
+                max_rss = r.rss_kb;
+            src = s;
+        }
+        double stddev() const {
+            double m = sum / n;
+            double v = sum2 / n - m * m;
+            return (v > 0) ? std::sqrt(v) : 0;
+        }
+    };
+    typedef std::map<std::string, Agg>                  agg_map;
+    typedef std::pair<double, agg_map::value_type const*> rank_t;
+
+    static bool greater_first(rank_t const& a, rank_t const& b) { return a.first > b.first; }
+
+    static void print_top(FILE* fp, char const* title, char const* unit, std::vector<rank_t>& v, std::size_t top) {
+        std::sort(v.begin(), v.end(), greater_first);
+        std::fprintf(fp, "\n%s: (%s, count, mean ms)\n", title, unit);
+        for (std::size_t i = 0; i < v.size() && i < top; ++i) {
+            Agg const&         a   = v[i].second->second;
+            std::string const& key = v[i].second->first;
+            if (key == a.src)
+                std::fprintf(fp, "  %10.1f %5u %10.1f  %s\n", v[i].first, unsigned(a.n), a.sum / a.n, key.c_str());
+            else
+                std::fprintf(fp, "  %10.1f %5u %10.1f  %s (%s ...)\n", v[i].first, unsigned(a.n), a.sum / a.n
+                             , key.c_str(), a.src.c_str());
+        }
+    }
+
+    static bool parse(std::string const& line, StatRec& r) {
+        std::string rc, wall, user, sys, rss;
+        if (!field(line, "kind", r.kind) || !field(line, "src", r.src) || !field(line, "wall_ms", wall))
+            return false;
+        field(line, "obj", r.obj);
+        field(line, "args", r.args);
+        field(line, "rc", rc);
+        field(line, "user_ms", user);
+        field(line, "sys_ms", sys);
+        field(line, "rss_kb", rss);
+        r.rc      = std::atoi(rc.c_str());
+        r.wall_ms = std::atof(wall.c_str());
+        r.user_ms = std::atof(user.c_str());
+        r.sys_ms  = std::atof(sys.c_str());
+        r.rss_kb  = (unsigned long long)std::atof(rss.c_str());
+        return true;
+    }
+
+    /// Value of "key": in a flat JSON object. (string unescaped)
+    static bool field(std::string const& line, char const* key, std::string& val) {
+        std::string k = std::string("\"") + key + "\":";
+        std::size_t p = line.find(k);
+        if (p == std::string::npos)
+            return false;
+        p += k.size();
+        val.clear();
+        if (p < line.size() && line[p] == '"') {
+            for (++p; p < line.size() && line[p] != '"'; ++p) {
+                if (line[p] == '\\' && p + 1 < line.size())
+                    ++p;
+                val += line[p];
+            }
+        } else {
+            std::size_t e = line.find_first_of(",}", p);
+            val = line.substr(p, e - p);
+        }
+        return true;
+    }
+
+private:
+    std::string path_;
+};
+
+#endif  // DMC_CC_STATS_HPP_INCLUDED
@@ -0,0 +1,108 @@
+/**
+ *  @file   dmc-cc-toolchain.hpp
+ *  @brief  Toolchain registry and the cache of the found toolchains of dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Registry (dmc-cc-toolchains.ini beside dmc-cc.exe, or DMC_CC_TOOLCHAINS):
+ *      # NAME      DMC_DIR             [LINKER]
+ *      default     c:\dm
+ *      new         c:\dmc              wlink
+ *    LINKER: optlink (default), link, wlink or a path.
+ *
+ *    Cache (STATE_DIR/toolchain.txt), one line per key, appended:
+ *      KEY \t EXEPATH \t BINDIR \t LINKER
+ *    KEY is the hash of everything the search depends on.
+ */
+#ifndef DMC_CC_TOOLCHAIN_HPP_INCLUDED
+#define DMC_CC_TOOLCHAIN_HPP_INCLUDED
+
+#include <cstring>
+#include <string>
+#include "file_util.hpp"
+
+struct Toolchain {
+    std::string     exepath;    // dmc.exe
+    std::string     bindir;     // with trailing separator.
+    std::string     linker;
+};
+
+class ToolchainCache {
+public:
+    void set_path(std::string const& path) { path_ = path; }
+
+    /// Cached toolchain of key, if its dmc.exe still exists.
+    bool find(std::string const& key, Toolchain& tc) const {
+        zatu::file_util::mapped_file mf(path_.c_str());
+        char const* p = mf.begin();
+        char const* e = mf.end();
+        while (p && p < e) {
+            char const* eol = static_cast<char const*>(std::memchr(p, '\n', e - p));
+            if (eol == NULL)
+                break;
+            if (std::size_t(eol - p) > key.size() && std::memcmp(p, key.data(), key.size()) == 0
+                && p[key.size()] == '\t')
+            {
+                std::string f[3];
+                char const* s = p + key.size() + 1;
+                for (int i = 0; i < 3 && s <= eol; ++i) {
+                    char const* t = static_cast<char const*>(std::memchr(s, '\t', eol - s));
+                    if (t == NULL || i == 2)
+                        t = eol;
+                    f[i].assign(s, t);
+                    s = t + 1;
+                }
+                tc.exepath = f[0];
+                tc.bindir  = f[1];
+                tc.linker  = f[2];
+                zatu::file_util::file_stat_t st;
+                return zatu::file_util::file_stat(tc.exepath.c_str(), st);
+            }
+            p = eol + 1;
+        }
+        return false;
+    }
+
+    bool add(std::string const& key, Toolchain const& tc) const {
+        std::string dir = path_.substr(0, path_.find_last_of("/\\") + 1);
+        if (!dir.empty() && !zatu::file_util::make_dirs(dir))
+            return false;
+        return zatu::file_util::file_append(path_.c_str(), key + "\t" + tc.exepath + "\t" + tc.bindir + "\t"
+                                            + tc.linker + "\n");
+    }
+
+    /// DMC_DIR and LINKER of name in the registry text.
+    static bool profile(std::string const& text, std::string const& name, std::string& dir, std::string& linker) {
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t eol = text.find('\n', pos);
+            if (eol == std::string::npos)
+                eol = text.size();
+            std::string f[3];
+            int         n = 0;
+            for (std::size_t i = pos; i < eol && n < 3 && text[i] != '#'; ) {
+                if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') {
+                    ++i;
+                    continue;
+                }
+                std::size_t b = i;
+                while (i < eol && text[i] != ' ' && text[i] != '\t' && text[i] != '\r')
+                    ++i;
+                f[n++].assign(text, b, i - b);
+            }
+            if (n >= 2 && f[0] == name) {
+                dir    = f[1];
+                linker = f[2];
+                return true;
+            }
+            pos = eol + 1;
+        }
+        return false;
+    }
+
+private:
+    std::string     path_;
+};
+
+#endif  // DMC_CC_TOOLCHAIN_HPP_INCLUDED
@@ -0,0 +1,118 @@
+/**
+ *  @file   dmc-cc-trace.hpp
+ *  @brief  Chrome trace event (--CC-trace=FILE) recorder of dmc-cc.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Events are kept in memory and appended to FILE by one write at exit,
+ *    so concurrent make -j processes can share FILE.
+ *    FILE is "[" followed by "{...},\n" lines. (the closing "]" is optional)
+ *    ts is wall clock microseconds, so the processes line up in one timeline.
+ */
+#ifndef DMC_CC_TRACE_HPP_INCLUDED
+#define DMC_CC_TRACE_HPP_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include "file_util.hpp"
+#include "proc_util.hpp"
+#if !defined(_WIN32)
+#include <sys/time.h>
+#endif
+
+/// Append s to d, escaped for a JSON string.
+inline void json_escape(std::string& d, std::string const& s) {
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            d += '\\';
+            d += char(c);
+        } else if (c < 0x20) {
+            char buf[8];
+            std::sprintf(buf, "\\u%04x", c);
+            d += buf;
+        } else {
+            d += char(c);
+        }
+    }
+}
+
+class Tracer {
+public:
+    typedef unsigned long long  time_type;
+
+    Tracer() : pid_(zatu::proc_util::get_pid()) {}
+
+    bool enabled() const { return !path_.empty(); }
+
+    void set_path(std::string const& path) { path_ = path; }
+
+    std::string const& path() const { return path_; }
+
+    /// Microseconds since 1970.
+    static time_type now() {
+     #if defined(_WIN32)
+        FILETIME ft;
+        GetSystemTimeAsFileTime(&ft);
+        time_type t = (time_type)ft.dwHighDateTime << 32 | ft.dwLowDateTime;
+        return t / 10 - 11644473600000000ULL;
+     #else
+        timeval tv;
+        gettimeofday(&tv, NULL);
+        return (time_type)tv.tv_sec * 1000000ULL + tv.tv_usec;
+     #endif
+    }
+
+    /** Record a span [begin, end) named name.
+     *  tu: source file tag.  tid: 0 for dmc-cc itself, 1.. for child slots.
+     */
+    void span(char const* name, char const* cat, time_type begin, time_type end
+              , std::string const& tu = std::string(), unsigned tid = 0)
+    {
+        char buf[160];
+        std::sprintf(buf, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%u,\"tid\":%u"
+                     , name, cat, begin, (end > begin) ? end - begin : 0ULL, pid_, tid);
+        events_ += buf;
+        if (!tu.empty()) {
+            events_ += ",\"args\":{\"tu\":\"";
+            json_escape(events_, tu);
+            events_ += "\"}";
+        }
+        events_ += "},\n";
+    }
+
+    /// Append the recorded events to the trace file.
+    void flush() {
+        if (!enabled() || events_.empty())
+            return;
+        zatu::file_util::file_save_new(path_.c_str(), "[\n");
+        zatu::file_util::file_append(path_.c_str(), events_);
+        events_.clear();
+    }
+
+private:
+    std::string path_;
+    std::string events_;
+    unsigned    pid_;
+};
+
+/// Record the lifetime of this object as a span.
+class TraceScope {
+public:
+    TraceScope(Tracer& tr, char const* name, std::string const& tu = std::string())
+        : tr_(tr), name_(name), tu_(tu), begin_(Tracer::now()) {}
+    ~TraceScope() { tr_.span(name_, "dmc-cc", begin_, Tracer::now(), tu_); }
+
+private:
+    TraceScope(TraceScope const&);
+    TraceScope& operator=(TraceScope const&);
+
+private:
+    Tracer&             tr_;
+    char const*         name_;
+    std::string         tu_;
+    Tracer::time_type   begin_;
+};
+
+#endif  // DMC_CC_TRACE_HPP_INCLUDED
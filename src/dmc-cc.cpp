@@ -7,241 +7,1240 @@
  *  @note
  */
 #include <utility>
+#include <algorithm>
+#include <set>
+#include <map>
 #include <vector>
 #include <string>
 #include <cstdio>
 #include <cstdlib>
+#include <cstdarg>
 #include <cassert>
+#include <cctype>
+#if defined(_WIN32)
 #include <process.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#define _snprintf   snprintf
+#endif
+#if !defined(_MAX_PATH)
+#define _MAX_PATH   260
+#endif
 
 #define ZATU_UNUSE_WCHAR_T
 #define ZATU_USE_CMD_LINE_ARGS_UTIL
 #include "cmd_line_args.hpp"
+#include "proc_util.hpp"
+#include "file_util.hpp"
+#include "hash_util.hpp"
+#include "net_util.hpp"
+#include "jobserver_util.hpp"
+#include "watch_util.hpp"
+#include "dmc-cc-cache.hpp"
+#include "dmc-cc-opts.hpp"
+#include "dmc-cc-deps.hpp"
+#include "dmc-cc-incdirs.hpp"
+#include "dmc-cc-history.hpp"
+#include "dmc-cc-probe.hpp"
+#include "dmc-cc-trace.hpp"
+#include "dmc-cc-stats.hpp"
+#include "dmc-cc-link.hpp"
+#include "dmc-cc-ar.hpp"
+#include "dmc-cc-libs.hpp"
+#include "dmc-cc-toolchain.hpp"
+#include "dmc-cc-diag.hpp"
 
 using namespace std;
 using namespace zatu;
 using namespace zatu::cmd_line_args_util;
 
+#define DMC_CC_SERVER_PORT  4717
+#define DMC_CC_SERVER_CONNS 60      // clients the server reads at a time. (FD_SETSIZE is 64 on Windows)
+#define DMC_CC_SERVER_IDLE  10000   // ms a client may take to send its request.
+#define DMC_CC_AUTH         "dmc-cc auth 1"
+#define DMC_CC_WORKER_PORT  4718
+#define DMC_CC_REMOTE_RETRY 75      // exit code of --CC-remote: compile it locally.
+
+#if !defined(DMC_CC_REMOTE)
+#define DMC_CC_REMOTE       0       // 1: --CC-workers preprocesses by sppn.exe -e -lLIST. (not yet run with real DMC)
+#endif
+
+#if !defined(DMC_CC_CMDLINE_MAX)
+#define DMC_CC_CMDLINE_MAX  8000    // longer command lines are passed by @file.
+#endif
+
+
+/// What the --CC-server process keeps between requests.
+struct ServerCache {
+    string              secret;
+    set<string>         env_names;  // environment variables set now.
+    string              tc_key;     // what exepath.. depend on.
+    string              exepath;
+    string              bindir;
+    string              linker;
+    string              ini_path;
+    string              ini_text;
+    unsigned long long  ini_mtime;
+    bool                ini_exist;
+    ServerCache() : ini_mtime(0), ini_exist(false) {}
+};
+
+/// A client of the --CC-server process.
+struct ServerConn {
+    net_util::socket_t              sock;
+    string                          buf;    // received part of the request.
+    unsigned long long              since;  // Tracer::now() of the last data.
+    string                          nonces; // of the client and the server. ("": before the hello)
+    bool                            authed; // the client proved the secret.
+    ServerConn() : sock(net_util::invalid_socket()), since(0), authed(false) {}
+};
+
 
 class Program {
+    friend class ProgramBench;  // bench/dmc-cc-bench.cpp
+
+    /// Compile of one source. (--CC-jobs, --CC-cache, --CC-workers)
+    struct Job {
+        enum { PREPROCESS, REMOTE, COMPILE, DONE };
+        vector<string>      src;        // one source.
+        string              obj;
+        string              obj_opt;    // -oOBJ
+        string              log;        // captured stdout/stderr.
+        string              out;        // output to print.
+        string              lst_opt;    // -lLIST  preprocessed source.
+        string              key;        // cache key.
+        string              key_stamp;  // hash of the stamps of the files in key.
+        vector<string>      key_files;  // and the paths the #include lookups found missing.
+        string              hkey;       // CompileHistory key.
+        string              rsp_opt;    // @RSP of args.
+        string              pre_rsp_opt;
+        vector<char const*> args;
+        vector<char const*> pre_args;   // sppn -e -lLIST
+        vector<char const*> remote_args;    // dmc-cc --CC-remote LIST OBJ EXT WORKERS FLAGS
+        string              remote_workers; // in the order to try.
+        int                 worker;     // first one of remote_workers.
+        int                 phase;
+        int                 rc;
+        unsigned            slot;       // process slot. (trace tid - 1)
+        Tracer::time_type   start;      // start time of the phase.
+        Tracer::time_type   begun;      // start time of the first phase.
+        vector<size_t>      members;    // files_ index of the sources of a unity TU.
+        Job() : worker(0), phase(COMPILE), rc(0), slot(0), start(0), begun(0) {}
+    };
+
+    /// Compile request being run by --CC-worker.
+    struct WorkerTask {
+        net_util::socket_t  sock;
+        proc_util::proc_t   proc;
+        string              src;
+        string              obj;
+        string              log;
+    };
+
+    /// -I, -L/ and -HI paths already added. (conv_gcc_to_native_args)
+    struct PathOpts {
+        std::set<string>    seen;       // prefix + full path.
+        unsigned            dups;
+        unsigned            missing;
+        PathOpts() : dups(0), missing(0) {}
+    };
+
     vector<string>      opts_;
     vector<string>      files_;
+    vector<string>      native_files_;  // files_ as given, before '/' -> '\'. (--CC-watch)
     vector<string>      libs_;
     vector<char const*> dst_args_;
+    string              out_opt_;   // -oFILE
     string              bindir_;
     string              exepath_;
+    string              linker_;    // --CC-linker: optlink, link, wlink or path.
+    string              tc_linker_; // linker of the toolchain.
     char const*         ccpath_;
+    unsigned            jobs_;
+    unsigned            unity_;     // --CC-unity=K
+    vector<string>      unity_excl_;
+    bool                compile_only_;
     bool                print_args_;
     bool                verbose_;
+    bool                help_;
+    bool                cache_stats_;
+    bool                stats_;     // --CC-stats
+    bool                native_diag_;   // --CC-native-diag
+    bool                prune_inc_;     // --CC-prune-includes
+    bool                watch_;         // --CC-watch
+    vector<bool>        only_;      // files_ that compile_jobs compiles. (empty: all)
+    int                 dep_mode_;  // DEP_ALL(-MD) or DEP_USER(-MMD).
+    bool                dep_phony_; // -MP
+    string              dep_file_;  // -MF
+    string              dep_targets_;   // -MT -MQ
+    ObjCache            cache_;
+    Tracer              trace_;
+    StatsLog            stats_log_;
+    CompileHistory      history_;
+    ServerCache*        server_;    // not NULL in --CC-server process.
+    string              msgs_;      // messages of conv_gcc_to_native_args.
+    string              opts_rsp_;  // @RSP of opts_.
+    string              opts_hash_;
+    string              workers_;   // --CC-workers  HOST:PORT,...
+    vector<string>      remote_flags_;  // opts_ sent to workers.
+    vector<unsigned>    worker_load_;   // running jobs of each worker.
+    string              self_path_;
+    string              sppn_;          // preprocessor beside dmc.exe, for workers.
+    jobserver_util::client js_;     // MAKEFLAGS --jobserver-auth
+    string*             capture_;   // receives the output printed by run_child. (probe)
+
+    enum { DEP_NONE, DEP_ALL, DEP_USER };
 
 public:
-    Program() : ccpath_(NULL), print_args_(false), verbose_(false) {}
+    Program()
+        : ccpath_(NULL), jobs_(1), unity_(0), compile_only_(false), print_args_(false), verbose_(false)
+        , help_(false), cache_stats_(false), stats_(false), native_diag_(false), prune_inc_(false), watch_(false), dep_mode_(DEP_NONE), dep_phony_(false), server_(NULL), capture_(NULL)
+    {}
 
-    int main(int argc, char* argv[], char** env) {
+    int main(int argc, char* argv[]) {
+        Tracer::time_type start = Tracer::now();
         ccpath_ = argv[0];
+        if (is_ar_name(fname_base(argv[0])))
+            return ar_main(argc, argv);
         if (argc < 2)
             return usage();
+        if (strcmp(argv[1], "--CC-ar") == 0)
+            return ar_main(argc - 1, argv + 1);
+        if (strcmp(argv[1], "--CC-server-stop") == 0)
+            return server_stop();
+        if (strncmp(argv[1], "--CC-server", 11) == 0)
+            return server_main(argv[1]);
+        if (strncmp(argv[1], "--CC-worker-stop", 16) == 0)
+            return worker_stop(argv[1]);
+        if (strncmp(argv[1], "--CC-worker", 11) == 0 && argv[1][11] != 's')
+            return worker_main(argv[1]);
+        if (strcmp(argv[1], "--CC-remote") == 0)
+            return remote_main(argc, argv);
 
-        get_exepath(ccpath_);
+        char const* cache_dir = getenv("DMC_CC_CACHE_DIR");
+        if (cache_dir && *cache_dir)
+            cache_.set_dir(cache_dir);
+        char const* trace = getenv("DMC_CC_TRACE");
+        if (trace && *trace)
+            trace_.set_path(trace);
+        char const* workers = getenv("DMC_CC_WORKERS");
+        if (workers)
+            workers_ = workers;
+        stats_log_.set_path(file_util::path_join(state_dir(), "stats.jsonl"));
+        history_.set_path(file_util::path_join(state_dir(), "durations.txt"));
 
-        opts_.reserve(512);
-        files_.reserve(512);
-        libs_.reserve(64);
-        if (conv_gcc_to_native_args(argc, argv) != 0)
-            return 1;
+        int rc = client_translate(argc, argv);
+        if (rc < 0) {
+            {
+                TraceScope  ts(trace_, "exepath");
+                char const* tc = getenv("DMC_CC_TOOLCHAIN");
+                if (!reports_only(argc, argv) && !get_exepath(ccpath_, tc ? tc : ""))
+                    return 1;
+            }
+            {
+                TraceScope ts(trace_, "translate");
+                rc = conv_gcc_to_native_args(argc, argv);
+            }
+            fputs(msgs_.c_str(), stderr);
+        }
+        if (rc == 0)
+            rc = run();
+        trace_.span("dmc-cc", "dmc-cc", start, Tracer::now(), first_source());
+        trace_.flush();
+        return rc;
+    }
+
+private:
+    /// true if argv asks for something without dmc, so that dmc.exe need not be searched.
+    static bool reports_only(int argc, char* argv[]) {
+        static char const* const opts[] = { "--help", "--CC-stats", "--CC-cache-stats", "--CC-server-stop" };
+        for (int i = 1; i < argc; ++i) {
+            for (size_t k = 0; k < sizeof opts / sizeof opts[0]; ++k) {
+                if (strcmp(argv[i], opts[k]) == 0)
+                    return true;
+            }
+        }
+        return false;
+    }
 
+    int run() {
+        if (help_)
+            return usage();
+        if (cache_stats_) {
+            if (!cache_.enabled()) {
+                fprintf(stderr, "%s: no cache directory. (--CC-cache=DIR or DMC_CC_CACHE_DIR)\n", fname_base(ccpath_));
+                return 1;
+            }
+            return cache_.print_stats();
+        }
+        if (stats_)
+            return stats_log_.report(stdout);
+
+        size_t srcs = count_sources();
+        js_.open(getenv("MAKEFLAGS"));
+        if (watch_ && !print_args_)
+            return watch();
+        if (((jobs_ > 1 || js_.enabled()) && srcs > 1) || (cache_.enabled() && srcs > 0) || (unity_ > 1 && srcs > 1 && !compile_only_)
+            || (!workers_.empty() && srcs > 0))
+            return compile_jobs();
+        string probe = probe_key();
+        if (!probe.empty())
+            return run_probe(probe, srcs);
+        return run_one(srcs);
+    }
+
+    /// Compile and/or link by one dmc.
+    int run_one(size_t srcs) {
+        if (prune_inc_ && srcs == 1) {
+            TraceScope ts(trace_, "prune-includes");
+            prune_includes(vector<vector<char const*>*>(1, &dst_args_), vector<string>(1, first_source()));
+        }
         char** dst_argv = (char**)&dst_args_[0];
 
         if (print_args(dst_argv) == 0)
             return 0;
 
-        int rc = execve(exepath_.c_str(), dst_argv, env);
+        if (dep_mode_ != DEP_NONE) {
+            vector<string> objs;
+            obj_names(objs);
+            write_deps(objs);
+        }
+
+        if (!compile_only_ && srcs == 0)
+            return link(dst_args_, files_);
+        if (!compile_only_) {
+            vector<string> files(files_);
+            for (size_t i = 0; i < libs_.size(); ++i)
+                files.push_back(find_lib(libs_[i]));
+            if (complete_archives(files) != 0)
+                return 1;
+        }
+
+        string rsp_opt;
+        fit_cmdline(dst_args_, rsp_opt);
+        string obj;
+        if (compile_only_ && srcs == 1) {
+            vector<string> objs;
+            obj_names(objs);
+            for (size_t i = 0; i < files_.size(); ++i) {
+                if (is_src_file(files_[i].c_str()))
+                    obj = objs[i];
+            }
+        } else if (!out_opt_.empty()) {
+            obj = out_opt_.substr(2);
+        }
+        return run_child(compile_only_ ? "compile" : srcs ? "dmc" : "link", dst_args_, first_source(), obj);
+    }
+
+    /** Key of the result of a CMake probe (compiler id, ABI check, try_compile):
+     *  the options, INCLUDE, LIB, the names and contents of the inputs, the paths and
+     *  contents of the headers they include (system ones too), the paths the #include lookups
+     *  tried that did not exist, and the paths and stamps of the libraries. The output name is not in it, as try_compile makes a new one
+     *  each time. "" if this is not a probe or a source has an #include of a macro.
+     */
+    string probe_key() const {
+        if (print_args_ || native_diag_ || dep_mode_ != DEP_NONE || getenv("DMC_CC_NO_PROBE_CACHE"))
+            return string();
+        bool probe = is_probe_path(out_opt_);
+        for (size_t i = 0; i < files_.size(); ++i)
+            probe = probe || is_probe_path(files_[i]);
+        if (!probe)
+            return string();
+        hash_util::fnv1a128 h;
+        h.add("probe 3");
+        for (size_t i = 0; i < opts_.size(); ++i)
+            h.add(opts_[i]);
+        h.add(compile_only_ ? "-c" : "");
+        char const* env_inc = getenv("INCLUDE");
+        char const* env_lib = getenv("LIB");
+        h.add(env_inc ? env_inc : "").add(env_lib ? env_lib : "");
+        vector<string> user_dirs, sys_dirs, forced;
+        include_dirs(user_dirs, sys_dirs, forced);
+        IncludeScanner sc;
+        sc.set_cache_path(file_util::path_join(state_dir(), "includes.txt"));
+        sc.set_dirs(user_dirs, sys_dirs);
+        h.add_u64(files_.size());
+        for (size_t i = 0; i < files_.size(); ++i) {
+            string text;
+            if (!file_util::file_read(files_[i].c_str(), text))
+                return string();
+            h.add(fname_base(files_[i].c_str())).add(text.data(), text.size());
+            if (!is_src_file(files_[i].c_str()))
+                continue;
+            vector<string> deps, misses;
+            sc.scan(files_[i], forced, false, deps, NULL, &misses);
+            if (sc.computed())
+                return string();
+            h.add_u64(deps.size());
+            for (size_t j = 1; j < deps.size(); ++j) {
+                if (!file_util::file_read(deps[j].c_str(), text))
+                    return string();
+                h.add(file_util::full_path(deps[j])).add(text.data(), text.size());
+            }
+            h.add_u64(misses.size());
+            for (size_t j = 0; j < misses.size(); ++j)
+                h.add(file_util::full_path(misses[j]));
+        }
+        for (size_t i = 0; i < libs_.size(); ++i) {
+            string                 path = find_lib(libs_[i]);
+            file_util::file_stat_t st;
+            file_util::file_stat(path.c_str(), st);
+            h.add(libs_[i]).add(file_util::full_path(path)).add_u64(st.size).add_u64(st.mtime);
+        }
+        return h.hex();
+    }
+
+    /// Under CMakeFiles\...\CompilerId*, CMakeScratch, CMakeTmp or TryCompile-*.
+    static bool is_probe_path(string const& path) {
+        size_t p = path.find("CMakeFiles\\");
+        if (p == string::npos)
+            return false;
+        return path.find("\\CompilerId", p) != string::npos || path.find("\\CMakeScratch\\", p) != string::npos
+            || path.find("\\CMakeTmp\\", p) != string::npos || path.find("\\TryCompile-", p) != string::npos;
+    }
+
+    /// Replay the result of the same probe, or run it and keep its result if its inputs did not change meanwhile.
+    int run_probe(string const& key, size_t srcs) {
+        file_util::file_stat_t dmc, self;
+        file_util::file_stat(exepath_.c_str(), dmc);
+        file_util::file_stat(proc_util::self_path(ccpath_).c_str(), self);
+        ProbeCache pc;
+        pc.set_dir(file_util::path_join(file_util::path_join(state_dir(), "probe")
+                   , hash_util::fnv1a64().add(exepath_).add_u64(dmc.size).add_u64(dmc.mtime)
+                                         .add_u64(self.size).add_u64(self.mtime).hex()));
+        string out;
+        if (compile_only_) {
+            vector<string> objs;
+            obj_names(objs);
+            for (size_t i = 0; i < files_.size(); ++i) {
+                if (is_src_file(files_[i].c_str()))
+                    out = objs[i];
+            }
+        } else {
+            out = link_output(files_);
+        }
+        string text;
+        int    rc = 0;
+        if (pc.get(key, out, text, rc)) {
+            if (verbose_)
+                fprintf(stderr, "%s: %s: cached probe result\n", fname_base(ccpath_), first_source().c_str());
+            fwrite(text.data(), 1, text.size(), stdout);
+            fflush(stdout);
+            return rc;
+        }
+        capture_ = &text;
+        rc = run_one(srcs);
+        capture_ = NULL;
+        if (probe_key() == key)
+            pc.put(key, out, text, rc);
         return rc;
     }
 
-private:
-    void get_exepath(char const* exepath) {
-        char buf[_MAX_PATH*2] = {0};
-        strncpy(buf, exepath, sizeof(buf)-1);
-        char* b = fname_base(buf);
-        strcpy(b, "dmc.exe");
-        exepath_ = buf;
-        if (!file_exist(buf)) {
-            char const* envdir = getenv("DMC_DIR");
-            if (!envdir || !file_exist(envdir))
-                envdir = getenv("DMC");
-            if (!envdir || !file_exist(envdir)) {
-                if (file_exist("c:\\dm\\bin"))
-                    envdir = "c:\\dm";
-                else if (file_exist("c:\\DMC\\dm\\bin"))
-                    envdir = "c:\\dmc\\dm";
-                else //if (file_exist("c:\\dmc\\bin"))
-                    envdir = "c:\\dmc";
-            }
-            //printf("envdir=%s\n", envdir);
-            b = buf;
-            b += _snprintf(buf, (sizeof buf)-1-8, "%s\\bin\\", envdir);
-            strcpy(b, "dmc.exe");
-            exepath_ = buf;
-        }
-        *b = '\0';
-        bindir_ = buf;
-        str_fsl_to_bsl(bindir_);
-        //printf("dir=%s\n", buf);
-        //printf("exe=%s\n", exepath_.c_str());
+    /// Run args, wait for it, and record its span and resource usage.
+    int run_child(char const* kind, vector<char const*> const& args, string const& src, string const& obj) {
+        Tracer::time_type start = Tracer::now();
+        proc_util::proc_t p;
+        proc_util::pipe_t rd;
+        bool ok = native_diag_ ? proc_util::proc_start(&args[0], NULL, p) : proc_util::proc_start_pipe(&args[0], p, rd);
+        if (!ok) {
+            fprintf(stderr, "%s: cannot execute %s\n", fname_base(ccpath_), args[0]);
+            return 1;
+        }
+        if (!native_diag_) {
+            DiagTranslator tr;
+            char           buf[4096];
+            string         out;
+            for (;;) {
+                long n = proc_util::pipe_read(rd, buf, sizeof buf);
+                out.clear();
+                if (n > 0)
+                    tr.feed(buf, size_t(n), out);
+                else
+                    tr.finish(out);
+                if (!out.empty()) {
+                    fwrite(out.data(), 1, out.size(), stdout);
+                    fflush(stdout);
+                    if (capture_)
+                        *capture_ += out;
+                }
+                if (n <= 0)
+                    break;
+            }
+            proc_util::pipe_close(rd);
+        }
+        proc_util::proc_usage_t u;
+        int rc = proc_util::proc_wait(p, &u);
+        trace_.span(kind, "dmc", start, Tracer::now(), src.empty() ? obj : src, 1);
+        log_stats(kind, src, obj, rc, start, u);
+        return rc;
+    }
+
+    /// Hash of the translated options.
+    string const& opts_hash() {
+        if (opts_hash_.empty()) {
+            hash_util::fnv1a64 h;
+            for (size_t i = 0; i < opts_.size(); ++i)
+                h.add(opts_[i]);
+            opts_hash_ = h.hex();
+        }
+        return opts_hash_;
+    }
+
+    void log_stats(char const* kind, string const& src, string const& obj, int rc
+                   , Tracer::time_type start, proc_util::proc_usage_t const& u)
+    {
+        StatRec r;
+        r.kind    = kind;
+        r.src     = src;
+        r.obj     = obj;
+        r.args    = opts_hash();
+        r.rc      = rc;
+        r.wall_ms = (Tracer::now() - start) / 1000.0;
+        r.user_ms = u.user_sec * 1000.0;
+        r.sys_ms  = u.sys_sec * 1000.0;
+        r.rss_kb  = u.peak_rss / 1024;
+        stats_log_.append(r);
+    }
+
+    string first_source() const {
+        for (size_t i = 0; i < files_.size(); ++i) {
+            if (is_src_file(files_[i].c_str()))
+                return files_[i];
+        }
+        return files_.empty() ? string() : files_[0];
+    }
+
+    void msg(char const* fmt, ...) {
+        char    buf[0x400];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf, sizeof buf, fmt, ap);
+        va_end(ap);
+        if (n < 0 || n >= int(sizeof buf))
+            n = int(sizeof buf) - 1;
+        msgs_.append(buf, n);
+    }
+
+    /** dmc-cc --CC-server[=[HOST:]PORT]
+     *  Requests are read from up to DMC_CC_SERVER_CONNS clients at a time, and each
+     *  is answered when all of it has come. Only loopback unless DMC_CC_SECRET is set.
+     *  A client and the server prove to each other that they know the secret
+     *  (auth_client, auth_server) before the request is sent.
+     */
+    int server_main(char const* opt) {
+        string          host;
+        unsigned short  port = 0;
+        char const*     addr = (opt[11] == '=') ? opt + 12 : getenv("DMC_CC_SERVER");
+        if (!net_util::parse_host_port(addr, host, port)) {
+            host = "127.0.0.1";
+            port = DMC_CC_SERVER_PORT;
+        }
+        ServerCache cache;
+        if (!secret_ok(host, cache.secret))
+            return 1;
+        net_util::socket_t ls = net_util::tcp_listen(host.c_str(), port);
+        if (!net_util::sock_valid(ls)) {
+            fprintf(stderr, "%s: cannot listen %s:%u\n", fname_base(ccpath_), host.c_str(), port);
+            return 1;
+        }
+        printf("%s: server %s:%u\n", fname_base(ccpath_), host.c_str(), port);
+        fflush(stdout);
+
+        vector<string> env;
+        proc_util::env_list(env);
+        for (size_t i = 0; i < env.size(); ++i)
+            cache.env_names.insert(env[i].substr(0, env[i].find('=')));
+
+        vector<ServerConn>          conns;
+        vector<net_util::socket_t>  socks;
+        vector<char>                ready;
+        bool                        stop = false;
+        while (!stop) {
+            socks.assign(1, ls);
+            for (size_t i = 0; i < conns.size(); ++i)
+                socks.push_back(conns[i].sock);
+            if (net_util::wait_readable_any(&socks[0], socks.size(), 1000, ready) < 0)
+                continue;
+            Tracer::time_type now = Tracer::now();
+            for (size_t i = conns.size(); i-- > 0;) {
+                ServerConn& c    = conns[i];
+                int         r    = 0;
+                if (ready[i + 1]) {
+                    vector<string> req, res;
+                    long           n = net_util::recv_some(c.sock, c.buf);
+                    r = (n > 0) ? auth_server(c, cache.secret) : -1;
+                    if (r > 0)
+                        r = (c.buf.size() <= 0x4000000) ? net_util::parse_strs(c.buf, req) : -1;
+                    if (r > 0) {
+                        stop |= server_reply(cache, req, res);
+                        net_util::send_strs(c.sock, res);
+                    }
+                    c.since = now;
+                } else if (now - c.since > DMC_CC_SERVER_IDLE * 1000ULL) {
+                    r = -1;
+                }
+                if (r != 0) {
+                    net_util::sock_close(c.sock);
+                    conns.erase(conns.begin() + i);
+                }
+            }
+            if (ready[0]) {
+                ServerConn c;
+                c.sock  = net_util::tcp_accept(ls);
+                c.since = now;
+                if (net_util::sock_valid(c.sock) && conns.size() < DMC_CC_SERVER_CONNS) {
+                    net_util::sock_set_timeout(c.sock, DMC_CC_SERVER_IDLE);    // for the reply.
+                    conns.push_back(c);
+                } else {
+                    net_util::sock_close(c.sock);
+                }
+            }
+        }
+        for (size_t i = 0; i < conns.size(); ++i)
+            net_util::sock_close(conns[i].sock);
+        net_util::sock_close(ls);
+        return 0;
+    }
+
+    /** Answer req (of an authenticated client): "stop", or "translate" CWD ENVS... ARGS...
+     *  A request this cannot translate is answered "-1" (the client translates it).
+     *  @return true for stop.
+     */
+    bool server_reply(ServerCache& cache, vector<string>& req, vector<string>& res) {
+        vector<string> env;
+        size_t         i = 2;
+        res.assign(1, "-1");
+        res.push_back(string());
+        if (req.size() == 1 && req[0] == "stop") {
+            res[0] = "0";
+            return true;
+        }
+        if (req.size() < 2 || req[0] != "translate" || !load_strs(req, i, env) || i >= req.size() || !file_util::set_cwd(req[1].c_str()))
+            return false;
+        server_env(cache, env);
+        vector<char*> av;
+        for (size_t k = i; k < req.size(); ++k)
+            av.push_back(&req[k][0]);
+        av.push_back(NULL);
+        Program p;
+        p.server_ = &cache;
+        p.ccpath_ = av[0];
+        if (!reports_only(int(av.size() - 1), &av[0]) && !p.server_toolchain())
+            return false;
+        int rc = p.conv_gcc_to_native_args(int(av.size() - 1), &av[0]);
+        char buf[16];
+        sprintf(buf, "%d", rc);
+        res[0] = buf;
+        res[1] = p.msgs_;
+        p.save_state(res);
+        return false;
+    }
+
+    /// Make the environment that of the client: set the variables of env ("NAME=VALUE"), remove the others.
+    static void server_env(ServerCache& cache, vector<string> const& env) {
+        set<string> names;
+        for (size_t i = 0; i < env.size(); ++i) {
+            size_t e = env[i].find('=');
+            if (e == 0 || e == string::npos)
+                continue;
+            string      name = env[i].substr(0, e);
+            char const* cur  = getenv(name.c_str());
+            names.insert(name);
+            if (cur == NULL || env[i].compare(e + 1, string::npos, cur) != 0)
+                proc_util::env_set(name, env[i].c_str() + e + 1);
+        }
+        for (set<string>::iterator it = cache.env_names.begin(); it != cache.env_names.end(); ++it) {
+            if (names.find(*it) == names.end())
+                proc_util::env_set(*it, NULL);
+        }
+        cache.env_names.swap(names);
+    }
+
+    /// Set exepath_, bindir_ and tc_linker_ by the server cache. Search again if ccpath_ or the environment changed.
+    bool server_toolchain() {
+        ServerCache&       c = *server_;
+        hash_util::fnv1a64 h;
+        h.add(ccpath_);
+        if (file_util::full_path(ccpath_) != ccpath_)
+            h.add(file_util::get_cwd());     // the paths found are relative to it.
+        static char const* const envs[] = {
+            "DMC_CC_TOOLCHAIN", "DMC_CC_TOOLCHAINS", "DMC_CC_STATE_DIR", "DMC_DIR", "DMC", "PATH", "TEMP", "TMP", "TMPDIR"
+        };
+        for (size_t i = 0; i < sizeof envs / sizeof envs[0]; ++i) {
+            char const* v = getenv(envs[i]);
+            h.add(v ? v : "").add("\n");
+        }
+        string key = h.hex();
+        if (key != c.tc_key) {
+            char const* tc = getenv("DMC_CC_TOOLCHAIN");
+            if (!get_exepath(ccpath_, tc ? tc : ""))
+                return false;
+            c.tc_key    = key;
+            c.exepath   = exepath_;
+            c.bindir    = bindir_;
+            c.linker    = tc_linker_;
+            c.ini_path  = ini_path();
+            c.ini_exist = false;
+            c.ini_text.clear();
+        }
+        exepath_   = c.exepath;
+        bindir_    = c.bindir;
+        tc_linker_ = c.linker;
+        return true;
+    }
+
+    int server_stop() {
+        vector<string> req, res;
+        req.push_back("stop");
+        if (!server_request(req, res))
+            return 1;
+        if (res.empty() || res[0] != "0") {
+            fprintf(stderr, "%s: the server refused. (DMC_CC_SECRET or DMC_CC_STATE_DIR differs)\n", fname_base(ccpath_));
+            return 1;
+        }
+        return 0;
+    }
+
+    /** Send req to the server after the handshake, and receive res.
+     *  @return false if not connected. res is "denied" if the server did not prove the secret.
+     */
+    bool server_request(vector<string> const& req, vector<string>& res) {
+        string          host;
+        unsigned short  port = 0;
+        if (!net_util::parse_host_port(getenv("DMC_CC_SERVER"), host, port)) {
+            host = "127.0.0.1";
+            port = DMC_CC_SERVER_PORT;
+        }
+        net_util::socket_t s = net_util::tcp_connect(host.c_str(), port);
+        if (!net_util::sock_valid(s))
+            return false;
+        bool rc = net_util::sock_set_timeout(s, 30000);
+        if (rc && !auth_client(s, shared_secret()))
+            res.assign(1, "denied");
+        else
+            rc = rc && net_util::send_strs(s, req) && net_util::recv_strs(s, res);
+        net_util::sock_close(s);
+        return rc;
+    }
+
+    static string auth_proof(string const& secret, char const* who, string const& nonces) {
+        return hash_util::hmac_sha256_hex(secret, string(DMC_CC_AUTH " ") + who + "\n" + nonces);
+    }
+
+    /** Client side of the handshake on s:
+     *    C: DMC_CC_AUTH NC   S: NS HMAC(secret, server NC NS)   C: HMAC(secret, client NC NS)
+     *  The peer is trusted only if it proved the secret, so a process that took the port
+     *  first learns neither the secret nor the request, and cannot have anything run.
+     */
+    static bool auth_client(net_util::socket_t s, string const& secret) {
+        vector<string> v(2);
+        v[0] = DMC_CC_AUTH;
+        if (secret.empty() || !net_util::random_hex(16, v[1]))
+            return false;
+        string nc = v[1];
+        if (!net_util::send_strs(s, v) || !net_util::recv_strs(s, v, 256) || v.size() != 2)
+            return false;
+        string nonces = nc + "\n" + v[0];
+        if (!hash_util::equal_const_time(v[1], auth_proof(secret, "server", nonces)))
+            return false;
+        return net_util::send_strs(s, vector<string>(1, auth_proof(secret, "client", nonces)));
+    }
+
+    /** Server side of the handshake, on what of c has been received in c.buf.
+     *  @return 1: done (the rest of c.buf is the request)  0: more is needed  -1: failed.
+     */
+    static int auth_server(ServerConn& c, string const& secret) {
+        vector<string> v;
+        while (!c.authed) {
+            int r = net_util::parse_strs(c.buf, v, 256);
+            if (r <= 0)
+                return (r == 0 && c.buf.size() <= 1024) ? 0 : -1;
+            if (c.nonces.empty()) {
+                string ns;
+                if (v.size() != 2 || v[0] != DMC_CC_AUTH || v[1].size() != 32 || !net_util::random_hex(16, ns))
+                    return -1;
+                c.nonces = v[1] + "\n" + ns;
+                v[0] = ns;
+                v[1] = auth_proof(secret, "server", c.nonces);
+                if (!net_util::send_strs(c.sock, v))
+                    return -1;
+            } else {
+                if (v.size() != 1 || !hash_util::equal_const_time(v[0], auth_proof(secret, "client", c.nonces)))
+                    return -1;
+                c.authed = true;
+            }
+        }
+        return 1;
+    }
+
+    /** The secret shared by the server or the workers and their clients: DMC_CC_SECRET,
+     *  or STATE_DIR/secret, made with random bytes by the first one needing it.
+     *  "" if none, or if the file is not the user's own or others can read it.
+     */
+    static string shared_secret() {
+        char const* env = getenv("DMC_CC_SECRET");
+        if (env && *env)
+            return env;
+        string path = file_util::path_join(state_dir(), "secret");
+        string text;
+        if (!file_load(path.c_str(), text)) {
+            string key;
+            if (!file_util::make_dirs(state_dir()) || !net_util::random_hex(16, key))
+                return string();
+         #if !defined(_WIN32)
+            mode_t m = umask(077);
+         #endif
+            file_util::file_save_new(path.c_str(), key);    // or the one another process made.
+         #if !defined(_WIN32)
+            umask(m);
+         #endif
+            if (!file_load(path.c_str(), text))
+                return string();
+        }
+     #if !defined(_WIN32)
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0 || st.st_uid != getuid() || (st.st_mode & 077) != 0)
+            return string();
+     #endif
+        return text.substr(0, text.find_first_of("\r\n"));
+    }
+
+    /// Set secret for a server on host. Other than loopback, DMC_CC_SECRET is needed.
+    bool secret_ok(string const& host, string& secret) {
+        char const* env = getenv("DMC_CC_SECRET");
+        if (!net_util::is_loopback(host.c_str()) && !(env && *env)) {
+            fprintf(stderr, "%s: set DMC_CC_SECRET (the same for the clients) to listen on %s\n", fname_base(ccpath_), host.c_str());
+            return false;
+        }
+        secret = shared_secret();
+        if (secret.empty()) {
+            fprintf(stderr, "%s: cannot make %s, or it is not the user's own with mode 600\n", fname_base(ccpath_)
+                    , file_util::path_join(state_dir(), "secret").c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /** If DMC_CC_SERVER is set, let the server translate the arguments.
+     *  @return -1: not served (translate locally) other: result of conv_gcc_to_native_args.
+     */
+    int client_translate(int argc, char* argv[]) {
+        char const* addr = getenv("DMC_CC_SERVER");
+        if (addr == NULL || *addr == 0)
+            return -1;
+        vector<string> req, res, env;
+        TraceScope     ts(trace_, "server");
+        proc_util::env_list(env);
+        req.reserve(argc + env.size() + 4);
+        req.push_back("translate");
+        req.push_back(file_util::get_cwd());
+        save_strs(req, env);
+        for (int i = 0; i < argc; ++i)
+            req.push_back(argv[i]);
+        if (!server_request(req, res) || res.size() < 2)
+            return -1;
+        int rc = atoi(res[0].c_str());
+        if (rc < 0)
+            return -1;
+        fputs(res[1].c_str(), stderr);
+        if (rc == 0 && !load_state(res, 2))
+            return -1;
+        return rc;
+    }
+
+    /// Translated state, for --CC-server replies.
+    void save_state(vector<string>& v) const {
+        v.push_back(exepath_);
+        v.push_back(bindir_);
+        v.push_back(out_opt_);
+        v.push_back(cache_.dir());
+        v.push_back(trace_.path());
+        v.push_back(workers_);
+        char buf[64];
+        sprintf(buf, "%u %d %d %d %d %d %d %d %d %u %d %d %d", jobs_, compile_only_, print_args_, verbose_, help_, cache_stats_
+                , dep_mode_, dep_phony_, stats_, unity_, native_diag_, prune_inc_, watch_);
+        v.push_back(buf);
+        v.push_back(dep_file_);
+        v.push_back(dep_targets_);
+        save_strs(v, unity_excl_);
+        save_strs(v, opts_);
+        save_strs(v, files_);
+        save_strs(v, native_files_);
+        save_strs(v, libs_);
+    }
+
+    bool load_state(vector<string> const& v, size_t i) {
+        if (v.size() < i + 9)
+            return false;
+        exepath_ = v[i++];
+        bindir_  = v[i++];
+        out_opt_ = v[i++];
+        if (!v[i].empty())
+            cache_.set_dir(v[i]);
+        ++i;
+        if (!v[i].empty())
+            trace_.set_path(v[i]);
+        ++i;
+        workers_ = v[i++];
+        int f[11] = {0};
+        if (sscanf(v[i++].c_str(), "%u %d %d %d %d %d %d %d %d %u %d %d %d", &jobs_, &f[0], &f[1], &f[2], &f[3], &f[4]
+                   , &f[5], &f[6], &f[7], &unity_, &f[8], &f[9], &f[10]) != 13)
+            return false;
+        compile_only_ = f[0] != 0;
+        print_args_   = f[1] != 0;
+        verbose_      = f[2] != 0;
+        help_         = f[3] != 0;
+        cache_stats_  = f[4] != 0;
+        dep_mode_     = f[5];
+        dep_phony_    = f[6] != 0;
+        stats_        = f[7] != 0;
+        native_diag_  = f[8] != 0;
+        prune_inc_    = f[9] != 0;
+        watch_        = f[10] != 0;
+        dep_file_     = v[i++];
+        dep_targets_  = v[i++];
+        if (!load_strs(v, i, unity_excl_) || !load_strs(v, i, opts_) || !load_strs(v, i, files_) || !load_strs(v, i, native_files_)
+            || !load_strs(v, i, libs_) || native_files_.size() != files_.size())
+            return false;
+        make_args(dst_args_, compile_only_, out_opt_, files_, true);
+        return true;
+    }
+
+    static void save_strs(vector<string>& v, vector<string> const& a) {
+        char buf[16];
+        sprintf(buf, "%u", unsigned(a.size()));
+        v.push_back(buf);
+        v.insert(v.end(), a.begin(), a.end());
+    }
+
+    static bool load_strs(vector<string> const& v, size_t& i, vector<string>& a) {
+        if (i >= v.size())
+            return false;
+        size_t n = size_t(atol(v[i++].c_str()));
+        if (v.size() - i < n)
+            return false;
+        a.assign(v.begin() + i, v.begin() + i + n);
+        i += n;
+        return true;
+    }
+
+    string ini_path() const {
+        string str = ccpath_;
+        char*  ext = (char*)fname_ext(str.c_str());
+        if (strlen(ext) < 4)
+            return string();
+        str.resize(ext - str.c_str());
+        return str + ".ini";
+    }
+
+    /// dmc-cc.ini. The server reloads it only when its mtime changes.
+    bool load_ini(string& text) {
+        if (server_ == NULL) {
+            string path = ini_path();
+            if (path.empty() || !file_exist(path.c_str()))
+                return false;
+            return file_load(path.c_str(), text);
+        }
+        ServerCache&           c = *server_;
+        file_util::file_stat_t st;
+        bool exist = !c.ini_path.empty() && file_util::file_stat(c.ini_path.c_str(), st);
+        if (exist != c.ini_exist || (exist && st.mtime != c.ini_mtime)) {
+            c.ini_exist = exist && file_load(c.ini_path.c_str(), c.ini_text);
+            c.ini_mtime = st.mtime;
+        }
+        text = c.ini_text;
+        return c.ini_exist;
+    }
+
+    /** Find dmc.exe of the toolchain profile ("": default) and set exepath_, bindir_ and tc_linker_.
+     *  The result is cached in STATE_DIR/toolchain.txt, keyed by what the search depends on.
+     */
+    bool get_exepath(char const* ccpath, string const& profile) {
+        string                 reg_path = toolchains_path();
+        file_util::file_stat_t st;
+        file_util::file_stat(reg_path.c_str(), st);
+        hash_util::fnv1a64 h;
+        h.add("dmc-cc toolchain 1").add(file_util::full_path(ccpath)).add(profile);
+        h.add(reg_path).add_u64(st.size).add_u64(st.mtime);
+        static char const* const envs[] = { "DMC_DIR", "DMC", "PATH" };
+        for (size_t i = 0; i < sizeof envs / sizeof envs[0]; ++i) {
+            char const* v = getenv(envs[i]);
+            h.add(v ? v : "");
+        }
+        string         key = h.hex();
+        ToolchainCache cache;
+        cache.set_path(file_util::path_join(state_dir(), "toolchain.txt"));
+        Toolchain tc;
+        if (!cache.find(key, tc)) {
+            int rc = probe_toolchain(ccpath, profile, reg_path, tc);
+            if (rc < 0)
+                return false;
+            if (rc > 0)
+                cache.add(key, tc);
+        }
+        exepath_   = tc.exepath;
+        bindir_    = tc.bindir;
+        tc_linker_ = tc.linker;
+        return true;
+    }
+
+    /** Search dmc.exe: the profile of the registry, or the directory of dmc-cc, DMC_DIR, DMC,
+     *  PATH, c:\dm, c:\DMC\dm, c:\dmc.  @return 1: found  0: not found  -1: error
+     */
+    int probe_toolchain(char const* ccpath, string const& profile, string const& reg_path, Toolchain& tc) {
+        string name = profile.empty() ? string("default") : profile;
+        string reg, dir;
+        if (file_load(reg_path.c_str(), reg) && ToolchainCache::profile(reg, name, dir, tc.linker)) {
+            tc.exepath = file_util::path_join(file_util::path_join(dir, "bin"), "dmc.exe");
+            if (!file_exist(tc.exepath.c_str())) {
+                fprintf(stderr, "%s: toolchain %s: %s not found\n", fname_base(ccpath_), name.c_str(), tc.exepath.c_str());
+                return -1;
+            }
+        } else if (!profile.empty()) {
+            fprintf(stderr, "%s: unknown toolchain %s (%s)\n", fname_base(ccpath_), profile.c_str(), reg_path.c_str());
+            return -1;
+        } else {
+            vector<string> dirs;
+            string         self = ccpath;
+            dirs.push_back(self.substr(0, fname_base(self.c_str()) - self.c_str()));
+            static char const* const envs[] = { "DMC_DIR", "DMC" };
+            for (size_t i = 0; i < sizeof envs / sizeof envs[0]; ++i) {
+                char const* v = getenv(envs[i]);
+                if (v && *v)
+                    dirs.push_back(file_util::path_join(v, "bin"));
+            }
+         #if defined(_WIN32)
+            split_dirs(getenv("PATH"), dirs);
+         #else
+            split_dirs(getenv("PATH"), dirs, ':');
+         #endif
+            dirs.push_back("c:\\dm\\bin");
+            dirs.push_back("c:\\DMC\\dm\\bin");
+            dirs.push_back("c:\\dmc\\bin");
+            tc.exepath.clear();
+            for (size_t i = 0; i < dirs.size() && tc.exepath.empty(); ++i) {
+                string path = file_util::path_join(dirs[i], "dmc.exe");
+                if (file_exist(path.c_str()))
+                    tc.exepath = path;
+            }
+            if (tc.exepath.empty()) {
+                fprintf(stderr, "%s: dmc.exe not found. (set DMC_DIR)\n", fname_base(ccpath_));
+                tc.exepath = "dmc.exe";
+                tc.bindir.clear();
+                return 0;
+            }
+        }
+        tc.bindir = tc.exepath.substr(0, fname_base(tc.exepath.c_str()) - tc.exepath.c_str());
+        str_fsl_to_bsl(tc.bindir);
+        return 1;
+    }
+
+    /// DMC_CC_TOOLCHAINS or dmc-cc-toolchains.ini beside dmc-cc.
+    string toolchains_path() const {
+        char const* env = getenv("DMC_CC_TOOLCHAINS");
+        if (env && *env)
+            return env;
+        string path = ccpath_;
+        path.resize(fname_base(path.c_str()) - path.c_str());
+        return path + "dmc-cc-toolchains.ini";
+    }
+
+    /// -L option of the linker. ("" for link.exe, the default of dmc)
+    string linker_opt() {
+        string l = linker_.empty() ? tc_linker_ : linker_;
+        if (l.empty() || l == "optlink")
+            return "-L" + bindir_ + "optlink.exe";
+        if (l == "link")
+            return string();
+        if (l == "wlink") {
+            string wlink = ccpath_;
+            wlink.resize(fname_base(wlink.c_str()) - wlink.c_str());
+            wlink += "wlink.exe";
+            if (!file_exist(wlink.c_str()))
+                wlink = bindir_ + "wlink.exe";
+            return "-L" + wlink;
+        }
+        str_fsl_to_bsl(l);
+        return "-L" + l;
     }
 
     int conv_gcc_to_native_args(int argc, char* argv[]) {
         cmd_line_args<> args(argc, argv);
 
         // ini file load.
-        string str = ccpath_;
-        char*  ext = (char*)fname_ext(str.c_str());
-        if (strlen(ext) >= 4) {
-            strcpy(ext, ".ini");
-            if (file_exist(str.c_str()))
-                args.insert_response_str(file_load<string>(str.c_str()));
+        string str;
+        {
+            TraceScope ts(trace_, "ini");
+            if (load_ini(str))
+                args.insert_response_str(str);
         }
 
         bool cxx = false;
         bool gccmode = true;
         bool opt_linker = false;
+        vector<string> lib_names;
+        PathOpts paths;
 
         while (args.has_arg()) {
             if (args.prepare_get()) {  // option.
-                if (args.get_opt("--help")) {
-                    return usage();
-                } else if (args.get_opt("--CC-print-args", print_args_)) {
-                    continue;
-                } else if (args.get_opt("--GCC")) {
-                    gccmode = true;
-                    continue;
-                } else if (args.get_opt("--NATIVE") || args.get_opt("--DMC")) {
-                    gccmode = false;
+                OptDef const* d = find_opt(args.get_arg(), gccmode ? M_GCC : M_NATIVE);
+                if (d == NULL) {
+                    if (gccmode)
+                        msg("Ignore option %s\n", args.get_arg());
+                    else
+                        opts_.push_back(args.get_arg_0());
                     continue;
                 }
-                if (gccmode) {
-                    if (args.get_opt('D', str, false)) {
-                        opts_.push_back("-D");
-                        opts_.back() += str;
-                    } else if (args.get_opt("--define-macro", str)) {
-                        opts_.push_back("-D");
-                        opts_.back() += str;
-                    } else if (args.get_opt('U', str, false)) {
-                        opts_.push_back("-U");
-                        opts_.back() += str;
-                    } else if (args.get_opt("--undefine-macro", str)) {
-                        opts_.push_back("-U");
-                        opts_.back() += str;
-                    } else if (args.get_opt2('I', "--include-directory", str)) {
-                        opts_.push_back("-I");
-                        //str_fsl_to_bsl(str);
-                        opts_.back() += str;
-                    } else if (args.get_opt("--include", str)) {
-                        opts_.push_back("-HI");
-                        //str_fsl_to_bsl(str);
-                        opts_.back() += str;
-                    } else if (args.get_opt('c')) {
-                        opts_.push_back("-c");
-                    } else  if (args.get_opt2('o', "--output", str)) {
-                        opts_.push_back("-o");
-                        str_fsl_to_bsl(str);
-                        opts_.back() += str;
-                    } else  if (args.get_opt2('L', "--library-path", str)) {
-                        opts_.push_back("-L/");
-                        str_fsl_to_bsl(str);
-                        opts_.back() += str;
-                    } else  if (args.get_opt2('l', "--library", str)) {
-                        libs_.push_back("lib" + str + ".lib");
-                    } else if (args.get_opt("-Wall")) {
-                        opts_.push_back("-w");
-                    } else if (args.get_opt("-Werror")) {
-                        opts_.push_back("-wx");
-                    } else if (args.get_opt("--std=c++",str) || args.get_opt("--std=gnu++",str)) {
-                        opts_.push_back("-cpp");
-                        cxx = true;
-                    } else if (args.get_opt("--std=c",str) || args.get_opt("--std=gnu",str)) {
-                        cxx = false;
-                    } else if (args.get_opt("-g")) {
-                        opts_.push_back("-g");
-                    } else if (args.get_opt("--debug")) {
-                        opts_.push_back("-g");
-                    } else if (args.get_opt("-S")) {
-                        opts_.push_back("-cod");
-                    } else if (args.get_opt("-O0")) {
-                        opts_.push_back("-o+none");
-                    } else if (args.get_opt("-O1") || args.get_opt("-O2") || args.get_opt("-O3")) {
-                        opts_.push_back("-o+all");
-                    } else if (args.get_opt("-Ofast")) {
-                        opts_.push_back("-o+speed");
-                    } else if (args.get_opt("-Os") || args.get_opt("-Oz")) {
-                        opts_.push_back("-o+space");
-                    } else if (args.get_opt("-frtti")) {
-                        opts_.push_back("-Ar");
-                    } else if (args.get_opt("-fexceptions")) {
-                        opts_.push_back("-Ae");
-                    } else if (args.get_opt("-v2")) {
-                        opts_.push_back("-v2");
-                        verbose_ = true;
-                    } else if (args.get_opt2('v', "--verbose")) {
-                        opts_.push_back("-v1");
-                        verbose_ = true;
-                    } else if (args.get_opt("-fstack-check", str)) {
-                        if (str != "no")
-                            opts_.push_back("-s");
-                    } else if (args.get_opt("-funsigned-char")) {
-                        opts_.push_back("-J");
-                    } else if (args.get_opt("-fsigned-char")) {
-                    } else if (args.get_opt("-shared")) {
-                        opts_.push_back("-WD");
-                    } else if (args.get_opt("-mdll")) {
-                        opts_.push_back("-WD");
-                    } else if (args.get_opt("--ansi")) {
-                        opts_.push_back("-A");
-                    } else {
-                        //if (verbose_)
-                        fprintf(stderr, "Ignore option %s\n", args.get_arg());
-                    }
-                } else {    // dmc
-                    if (args.get_opt("-o+", str, false)) {
-                        opts_.push_back("-o+");
-                        opts_.back() += str;
-                    } else if (args.get_opt("-o-", str, false)) {
-                        opts_.push_back("-o-");
-                        opts_.back() += str;
-                    } else  if (args.get_opt("-o", str, false)) {
-                        opts_.push_back("-o");
+                bool flag = true;
+                str.clear();
+                if (d->kind == K_JOINED)
+                    args.get_opt(d->name, str, false);
+                else if (d->kind == K_ARG)
+                    args.get_opt(d->name, str, true);
+                else if (d->kind == K_BOOL)
+                    args.get_opt(d->name, flag);
+                switch (d->act) {
+                case A_OPT:
+                    if (d->dmc && (strcmp(d->dmc, "-I") == 0 || strcmp(d->dmc, "-HI") == 0))
+                        add_path_opt(d->dmc, str, paths);
+                    else
+                        opts_.push_back(d->dmc ? d->dmc + str : string(args.get_arg_0()));
+                    break;
+                case A_OPT_BSL:
+                    str_fsl_to_bsl(str);
+                    if (strcmp(d->dmc, "-L/") == 0)
+                        add_path_opt(d->dmc, str, paths);
+                    else
+                        opts_.push_back(d->dmc + str);
+                    break;
+                case A_NONE:
+                    break;
+                case A_COMPILE:
+                    compile_only_ = true;
+                    break;
+                case A_OUTPUT:
+                    str_fsl_to_bsl(str);
+                    out_opt_ = "-o" + str;
+                    break;
+                case A_LIB:
+                    lib_names.push_back(str);
+                    break;
+                case A_STD_CXX:
+                    opts_.push_back(d->dmc);
+                    cxx = true;
+                    break;
+                case A_STD_C:
+                    cxx = false;
+                    break;
+                case A_VERBOSE:
+                case A_QUIET:
+                    opts_.push_back(d->dmc ? string(d->dmc) : string(args.get_arg_0()));
+                    verbose_ = (d->act == A_VERBOSE);
+                    break;
+                case A_STACK_CHECK:
+                    if (str != "no")
+                        opts_.push_back(d->dmc);
+                    break;
+                case A_LINKER:
+                    opts_.push_back(d->dmc);
+                    if (str.size() > 0) {
                         str_fsl_to_bsl(str);
                         opts_.back() += str;
-                    } else  if (args.get_opt("-I", str, false)) {
-                        opts_.push_back("-I");
-                        //str_fsl_to_bsl(str);
-                        opts_.back() += str;
-                    } else  if (args.get_opt("-L/", str, false)) {
-                        opts_.push_back("-L/");
-                        opts_.back() += str;
-                    } else  if (args.get_opt("-L", str, false)) {
-                        opts_.push_back("-L");
-                        if (str.size() > 0) {
-                            str_fsl_to_bsl(str);
-                            opts_.back() += str;
-                            if (str != "link")
-                                opt_linker = true;
-                        }
-                    } else if (args.get_opt("-v0")) {
-                        opts_.push_back("-v0");
-                        verbose_ = false;
-                    } else if (args.get_opt("-v1") || args.get_opt("-v2")) {
-                        opts_.push_back(args.get_arg_0());
-                        verbose_ = true;
-                    } else {
-                        opts_.push_back(args.get_arg_0());
+                        if (str != "link")
+                            opt_linker = true;
                     }
+                    break;
+                case A_HELP:
+                    help_ = true;
+                    return 0;
+                case A_GCC:
+                    gccmode = true;
+                    break;
+                case A_NATIVE:
+                    gccmode = false;
+                    break;
+                case A_PRINT_ARGS:
+                    print_args_ = flag;
+                    break;
+                case A_JOBS:
+                    jobs_ = strz_to<unsigned>(str.c_str());
+                    if (jobs_ == 0)
+                        jobs_ = proc_util::cpu_count();
+                    break;
+                case A_TOOLCHAIN:
+                    if (!get_exepath(ccpath_, str))
+                        return 1;
+                    break;
+                case A_CC_LINKER:
+                    linker_ = str;
+                    break;
+                case A_WORKERS:
+                    workers_ = str;
+                    break;
+                case A_UNITY:
+                    unity_ = strz_to<unsigned>(str.c_str());
+                    break;
+                case A_UNITY_EXCLUDE:
+                    str_fsl_to_bsl(str);
+                    unity_excl_.push_back(str);
+                    break;
+                case A_CACHE:
+                    cache_.set_dir(str);
+                    break;
+                case A_CACHE_STATS:
+                    cache_stats_ = true;
+                    break;
+                case A_TRACE:
+                    trace_.set_path(str);
+                    break;
+                case A_STATS:
+                    stats_ = true;
+                    break;
+                case A_NATIVE_DIAG:
+                    native_diag_ = true;
+                    break;
+                case A_PRUNE_INC:
+                    prune_inc_ = true;
+                    break;
+                case A_WATCH:
+                    watch_ = true;
+                    break;
+                case A_DEP:
+                    dep_mode_ = DEP_ALL;
+                    break;
+                case A_DEP_USER:
+                    dep_mode_ = DEP_USER;
+                    break;
+                case A_DEP_FILE:
+                    dep_file_ = str;
+                    break;
+                case A_DEP_TARGET:
+                case A_DEP_QUOTE:
+                    if (!dep_targets_.empty())
+                        dep_targets_ += ' ';
+                    dep_targets_ += (d->act == A_DEP_QUOTE) ? IncludeScanner::make_escape(str) : str;
+                    break;
+                case A_DEP_PHONY:
+                    dep_phony_ = true;
+                    break;
+                case A_FIRST_ARG:
+                default:
+                    msg("%s must be the first argument\n", args.get_arg_0());
+                    break;
                 }
             } else if (*args.get_arg() == '@') {    // response file.
-                args.replace_response_str(file_load<string>(args.get_arg()+1));
+                char const* name = args.get_arg() + 1;
+                if (args.in_response(name)) {
+                    msg("Ignore recursive response file %s\n", name);
+                    continue;
+                }
+                TraceScope ts(trace_, "response", name);
+                file_util::mapped_file mf(name);
+                args.replace_response_str(mf.begin(), mf.end(), name);
             } else { // file.
                 files_.push_back(args.get_arg());
+                native_files_.push_back(files_.back());
                 str_fsl_to_bsl(files_.back());
                 char const* a = files_.back().c_str();
                 if (strcmp(fname_ext(a), ".cpp") == 0
@@ -252,38 +1251,1419 @@ private:
                 }
             }
         }
+        if (verbose_ && (paths.dups || paths.missing))
+            msg("Removed %u duplicate and %u missing -I/-L/-HI paths\n", paths.dups, paths.missing);
         if (cxx) {
             opts_.push_back("-Aa");
             opts_.push_back("-Ab");
         }
         if (!opt_linker) {
-		 #if defined USE_WLINK
-			string wlink = ccpath_;
-			wlink.resize(fname_base(wlink.c_str()) - wlink.c_str());
-			wlink += "wlink.exe";
-			if (file_exist(wlink.c_str()))
-            	opts_.push_back("-L" + wlink);
-			else
-		 #endif
-            	opts_.push_back("-L" + bindir_ + "optlink.exe");
-        }
-        size_t num = opts_.size() + files_.size();
-        dst_args_.reserve(num + 1);
-        dst_args_.push_back(exepath_.c_str());
+            string l = linker_opt();
+            if (!l.empty())
+                opts_.push_back(l);
+        }
+        if (!lib_names.empty()) {
+            TraceScope ts(trace_, "libs");
+            resolve_libs(lib_names);
+        }
+        make_args(dst_args_, compile_only_, out_opt_, files_, true);
+        return 0;
+    }
+
+    /** Add prefix + path (canonical) to opts_, unless the same path is already there
+     *  or the directory of -I/-L/ does not exist. A dmc "a;b" list is added as is.
+     */
+    void add_path_opt(char const* prefix, string path, PathOpts& po) {
+        str_fsl_to_bsl(path);
+        if (path.empty() || path.find(';') != string::npos) {
+            opts_.push_back(prefix + path);
+            return;
+        }
+        path = file_util::normalize_path(path, '\\');
+        string key = prefix + file_util::normalize_path(file_util::full_path(path), '\\');
+     #if defined(_WIN32)
+        for (size_t i = 0; i < key.size(); ++i)
+            key[i] = char(tolower((unsigned char)key[i]));
+     #endif
+        if (!po.seen.insert(key).second) {
+            ++po.dups;
+            return;
+        }
+        if (strcmp(prefix, "-HI") != 0) {
+            string dir = path;
+         #if !defined(_WIN32)
+            str_replace(dir, '\\', '/');
+         #endif
+            if (!file_util::is_dir(dir.c_str())) {
+                ++po.missing;
+                return;
+            }
+        }
+        opts_.push_back(prefix + path);
+    }
+
+    /// dst = exepath options [-c] [-oOUT] files [libs] NULL
+    void make_args(vector<char const*>& dst, bool compile_only, string const& out_opt
+                   , vector<string> const& files, bool with_libs) const
+    {
+        size_t num = opts_.size() + files.size() + libs_.size() + 3;
+        dst.clear();
+        dst.reserve(num + 1);
+        dst.push_back(exepath_.c_str());
         for (size_t i = 0; i < opts_.size(); ++i)
-            dst_args_.push_back(opts_[i].c_str());
+            dst.push_back(opts_[i].c_str());
+        if (compile_only)
+            dst.push_back("-c");
+        if (!out_opt.empty())
+            dst.push_back(out_opt.c_str());
+        for (size_t i = 0; i < files.size(); ++i)
+            dst.push_back(files[i].c_str());
+        if (with_libs) {
+            for (size_t i = 0; i < libs_.size(); ++i)
+                dst.push_back(libs_[i].c_str());
+        }
+        dst.push_back(NULL);
+    }
+
+    static bool is_src_file(char const* fname) {
+        char const* e = fname_ext(fname);
+        return strcmp(e, ".c") == 0 || strcmp(e, ".cpp") == 0
+            || strcmp(e, ".cxx") == 0 || strcmp(e, ".cc") == 0;
+    }
+
+    size_t count_sources() const {
+        size_t n = 0;
+        for (size_t i = 0; i < files_.size(); ++i)
+            n += is_src_file(files_[i].c_str());
+        return n;
+    }
+
+    /** --CC-watch: build, then wait for a source or a header it includes to change,
+     *  compile again the sources affected by it and link. Until killed (Ctrl-C).
+     *  The translated options are kept, and --CC-unity is not used.
+     */
+    int watch() {
+        if (count_sources() == 0) {
+            fprintf(stderr, "%s: --CC-watch needs a source file\n", fname_base(ccpath_));
+            return 1;
+        }
+        watch_util::watcher           w;
+        map<string, set<size_t> >     users;    // watched file -> files_ index of the sources using it.
+        vector<bool>                  dirty(files_.size(), false);
         for (size_t i = 0; i < files_.size(); ++i)
-            dst_args_.push_back(files_[i].c_str());
-        for (size_t i = 0; i < libs_.size(); ++i)
-            dst_args_.push_back(libs_[i].c_str());
-        dst_args_.push_back(NULL);
+            dirty[i] = is_src_file(files_[i].c_str());
+        for (;;) {
+            watch_scan(dirty, users);
+            vector<string> paths;
+            for (map<string, set<size_t> >::const_iterator it = users.begin(); it != users.end(); ++it)
+                paths.push_back(it->first);
+            w.set_files(paths);     // a change while compiling is seen by the next wait.
+
+            only_ = dirty;
+            int rc = compile_jobs();
+            only_.clear();
+            if (rc == 0)
+                dirty.assign(files_.size(), false);     // else kept to retry with the next change.
+            fprintf(stderr, "%s: %s. watching %u files%s\n", fname_base(ccpath_), rc ? "failed" : "done"
+                    , unsigned(paths.size()), w.notified() ? "" : " (polling)");
+
+            vector<string> changed;
+            w.wait(changed);
+            for (size_t i = 0; i < changed.size(); ++i) {
+                set<size_t> const& s = users[changed[i]];
+                for (set<size_t>::const_iterator it = s.begin(); it != s.end(); ++it)
+                    dirty[*it] = true;
+            }
+            size_t n = count(dirty.begin(), dirty.end(), true);
+            if (verbose_)
+                fprintf(stderr, "%s: %u files changed, %u sources to compile\n", fname_base(ccpath_)
+                        , unsigned(changed.size()), unsigned(n));
+        }
+    }
+
+    /** Find the headers of the dirty sources again, and update users by them.
+     *  The paths are in the native spelling, as the watcher stats them.
+     */
+    void watch_scan(vector<bool> const& dirty, map<string, set<size_t> >& users) const {
+        vector<string> user_dirs, sys_dirs, forced;
+        include_dirs(user_dirs, sys_dirs, forced);
+     #if !defined(_WIN32)
+        for (size_t i = 0; i < user_dirs.size(); ++i)
+            str_replace(user_dirs[i], '\\', '/');
+        for (size_t i = 0; i < sys_dirs.size(); ++i)
+            str_replace(sys_dirs[i], '\\', '/');
+        for (size_t i = 0; i < forced.size(); ++i)
+            str_replace(forced[i], '\\', '/');
+     #endif
+        IncludeScanner sc;
+        sc.set_cache_path(file_util::path_join(state_dir(), "includes.txt"));
+        sc.set_dirs(user_dirs, sys_dirs);
+        for (map<string, set<size_t> >::iterator it = users.begin(); it != users.end(); ) {
+            set<size_t>& s = it->second;
+            for (set<size_t>::iterator k = s.begin(); k != s.end(); ) {
+                if (dirty[*k])
+                    s.erase(k++);
+                else
+                    ++k;
+            }
+            if (s.empty())
+                users.erase(it++);
+            else
+                ++it;
+        }
+        vector<string> deps;
+        for (size_t i = 0; i < dirty.size(); ++i) {
+            if (!dirty[i])
+                continue;
+            sc.scan(native_files_[i], forced, true, deps);
+            for (size_t k = 0; k < deps.size(); ++k)
+                users[deps[k]].insert(i);
+        }
+    }
+
+    /** --CC-jobs / --CC-cache mode.
+     *  Compile each source by its own dmc -c process, at most jobs_ at a time,
+     *  print their outputs in the order of the sources, then link the objects.
+     */
+    int compile_jobs() {
+        if (compile_only_ && !out_opt_.empty() && count_sources() > 1) {
+            fprintf(stderr, "%s: cannot specify -o with -c and multiple files\n", fname_base(ccpath_));
+            return 1;
+        }
+        vector<Job>    jobs;
+        vector<string> objs;
+        obj_names(objs);
+        jobs.reserve(files_.size());
+        string   tmpbase = proc_util::temp_dir();
+        char     buf[64];
+        sprintf(buf, "dmc-cc-%u-", proc_util::get_pid());
+        tmpbase += buf;
+        vector<size_t> unity_job(files_.size(), size_t(-1));
+        if (!workers_.empty())
+            remote_setup();
+        if (unity_ > 1 && !compile_only_ && !watch_ && !make_unity_jobs(jobs, unity_job, tmpbase))
+            return 1;
+        for (size_t i = 0; i < files_.size(); ++i) {
+            if (is_src_file(files_[i].c_str()) && unity_job[i] == size_t(-1) && (only_.empty() || only_[i]))
+                add_job(jobs, files_[i], objs[i], tmpbase);
+        }
+        vector<string>      link_objs;
+        vector<char const*> link_args;
+        if (!compile_only_) {
+            get_link_objs(jobs, unity_job, objs, link_objs);
+            make_args(link_args, false, out_opt_, link_objs, true);
+        }
+
+        if (prune_inc_)
+            prune_job_includes(jobs);
+        if (print_args_) {
+            for (size_t i = 0; i < jobs.size(); ++i)
+                print_args((char**)&jobs[i].args[0]);
+            if (!compile_only_)
+                print_args((char**)&link_args[0]);
+            return 0;
+        }
+
+        if (dep_mode_ != DEP_NONE) {
+            TraceScope ts(trace_, "deps");
+            write_deps(objs);
+        }
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            fit_cmdline(jobs[i].args, jobs[i].rsp_opt);
+            if (jobs[i].phase == Job::PREPROCESS)
+                fit_cmdline(jobs[i].pre_args, jobs[i].pre_rsp_opt);
+        }
+        if (cache_.enabled())
+            cache_lookup(jobs);
+        int rc = run_jobs(jobs);
+
+        // Compile each source of the failed unity TUs by itself.
+        vector<Job> retry;
+        retry.reserve(files_.size());
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            vector<size_t> const& m = jobs[i].members;
+            if (m.empty() || jobs[i].rc == 0)
+                continue;
+            for (size_t k = 0; k < m.size(); ++k)
+                add_job(retry, files_[m[k]], objs[m[k]], tmpbase + "r");
+        }
+        if (!retry.empty()) {
+            if (prune_inc_)
+                prune_job_includes(retry);
+            for (size_t i = 0; i < retry.size(); ++i) {
+                fit_cmdline(retry[i].args, retry[i].rsp_opt);
+                if (retry[i].phase == Job::PREPROCESS)
+                    fit_cmdline(retry[i].pre_args, retry[i].pre_rsp_opt);
+            }
+            if (cache_.enabled())
+                cache_lookup(retry);
+            rc |= run_jobs(retry);
+            get_link_objs(jobs, unity_job, objs, link_objs);
+            make_args(link_args, false, out_opt_, link_objs, true);
+        }
+        if (rc != 0)
+            return 1;
+        if (compile_only_)
+            return 0;
+        return link(link_args, link_objs);
+    }
+
+    /** Link by args, unless the link manifest of the output says that args and
+     *  the contents of inputs and the libraries are the same as the last link.
+     */
+    int link(vector<char const*>& args, vector<string> const& inputs) {
+        string out = link_output(inputs);
+        LinkManifest lm(out);
+        {
+            TraceScope     ts(trace_, "link-check");
+            vector<string> files(inputs);
+            files.push_back(exepath_);
+            for (size_t i = 0; i < libs_.size(); ++i)
+                files.push_back(find_lib(libs_[i]));
+            if (complete_archives(files) != 0)
+                return 1;
+            if (lm.up_to_date(&args[0], files)) {
+                if (verbose_)
+                    fprintf(stderr, "%s: %s is up to date\n", fname_base(ccpath_), out.c_str());
+                return 0;
+            }
+        }
+        string rsp_opt;
+        fit_cmdline(args, rsp_opt);
+        print_args((char**)&args[0]);
+        int rc = run_child("link", args, string(), out);
+        if (rc == 0)
+            lm.save();
+        else
+            lm.clear();
+        return rc;
+    }
+
+    /** dmc-ar (dmc-cc named dmc-ar*, or dmc-cc --CC-ar ARGS): ar [-]OP[MODS] ARCHIVE [MEMBER...] by lib.exe.
+     *  r and q only update the member list of an existing ARCHIVE, unless the s modifier is given.
+     *  The list is put in ARCHIVE by one lib.exe: at s, or when dmc-cc links ARCHIVE.
+     *  A missing ARCHIVE is made at once, so that it exists when dmc-ar returns.
+     *  lib.exe is not run if the members and their contents are the same as the last time.
+     *  An archive not made by dmc-ar is updated by lib.exe at once.
+     */
+    int ar_main(int argc, char* argv[]) {
+        cmd_line_args<> args(argc, argv);
+        string         ops, lib, str;
+        vector<string> names;
+        bool           skip = false;    // relpos of a/b/i, or count of N.
+        while (args.has_arg()) {
+            if (args.prepare_get()) {  // option.
+                char const* a = args.get_arg();
+                if (args.get_opt("--plugin", str, true) || args.get_opt("--target", str, false))
+                    continue;
+                if (ops.empty() && a[1] != '-')
+                    ops = a + 1;
+                else
+                    msg("Ignore option %s\n", args.get_arg_0());
+            } else if (*args.get_arg() == '@') {    // response file.
+                char const* name = args.get_arg() + 1;
+                if (args.in_response(name)) {
+                    msg("Ignore recursive response file %s\n", name);
+                    continue;
+                }
+                file_util::mapped_file mf(name);
+                args.replace_response_str(mf.begin(), mf.end(), name);
+            } else if (ops.empty()) {
+                ops = args.get_arg();
+                skip = ops.find_first_of("abiN") != string::npos;
+            } else if (skip) {
+                skip = false;
+            } else {
+                string path = args.get_arg();
+                str_fsl_to_bsl(path);
+                if (lib.empty())
+                    lib = path;
+                else
+                    names.push_back(path);
+            }
+        }
+        fputs(msgs_.c_str(), stderr);
+        char op = 0;
+        for (size_t i = 0; i < ops.size() && !op; ++i) {
+            if (strchr("dmpqrtx", ops[i]))
+                op = ops[i];
+        }
+        bool index = ops.find('s') != string::npos;
+        if (!op && index)
+            op = 's';
+        verbose_ = ops.find('v') != string::npos;
+        if (!op || lib.empty()) {
+            fprintf(stderr, "usage> %s [-]{d|q|r|s|t|x}[cuvs] ARCHIVE [MEMBER...]\n", fname_base(ccpath_));
+            return 1;
+        }
+        if (op == 'm' || op == 'p') {
+            fprintf(stderr, "%s: operation %c is not supported\n", fname_base(ccpath_), op);
+            return 1;
+        }
+        char const* tc = getenv("DMC_CC_TOOLCHAIN");
+        if (!get_exepath(ccpath_, tc ? tc : ""))
+            return 1;
+
+        ArchiveMembers am(lib);
+        bool known  = am.load();
+        bool exists = file_exist(lib.c_str());
+        if (exists && !known) {
+            static char const* const prefix[] = { "-+", "+", "-", "*" };
+            char const* p = (op == 'r') ? prefix[0] : (op == 'q') ? prefix[1] : (op == 'd') ? prefix[2] : (op == 'x') ? prefix[3] : NULL;
+            if (p == NULL) {
+                if (op == 's')
+                    return 0;   // lib.exe always writes the dictionary.
+                fprintf(stderr, "%s: %s is not made by dmc-ar\n", fname_base(ccpath_), lib.c_str());
+                return 1;
+            }
+            return ar_lib(lib, p, names, op != 'x');
+        }
+        if (!exists && !am.pending())
+            am.clear();     // removed since the last lib.exe (e.g. by cmake before qc).
+        switch (op) {
+        case 'r':
+        case 'q':
+            if (!exists && !known && ops.find('c') == string::npos)
+                fprintf(stderr, "%s: creating %s\n", fname_base(ccpath_), lib.c_str());
+            for (size_t i = 0; i < names.size(); ++i)
+                names[i] = file_util::full_path(names[i]);
+            am.put(names);
+            am.set_pending(true);
+            if (!index && exists) {
+                if (!am.save()) {
+                    fprintf(stderr, "%s: cannot write %s\n", fname_base(ccpath_), am.path().c_str());
+                    return 1;
+                }
+                return 0;
+            }
+            return ar_flush(lib, am);
+        case 'd':
+            if (am.remove(names) != 0 && verbose_)
+                fprintf(stderr, "%s: some members are not in %s\n", fname_base(ccpath_), lib.c_str());
+            am.set_pending(true);
+            return ar_flush(lib, am);
+        case 't':
+            for (size_t i = 0; i < am.members().size(); ++i) {
+                string const& m = am.members()[i];
+                printf("%s\n", m.c_str() + m.find_last_of("/\\:") + 1);
+            }
+            return 0;
+        case 'x':
+            if (am.pending() && ar_flush(lib, am) != 0)
+                return 1;
+            if (names.empty()) {
+                for (size_t i = 0; i < am.members().size(); ++i)
+                    names.push_back(fname_base(am.members()[i].c_str()));
+            }
+            return ar_lib(lib, "*", names, false);
+        default:    // s
+            return am.pending() ? ar_flush(lib, am) : 0;
+        }
+    }
+
+    /// lib.exe beside dmc.exe.
+    string lib_exe() const {
+        return exepath_.substr(0, exepath_.find_last_of("/\\") + 1) + "lib.exe";
+    }
+
+    static bool is_ar_name(char const* name) {
+        static char const ar[] = "dmc-ar";
+        for (size_t i = 0; i < sizeof ar - 1; ++i) {
+            if (tolower((unsigned char)name[i]) != ar[i])
+                return false;
+        }
+        return true;
+    }
+
+    /// lib.exe [-n] LIB prefix+name... (update of an archive by its own syntax)
+    int ar_lib(string const& lib, char const* prefix, vector<string> const& names, bool no_backup) {
+        string              libexe = lib_exe();
+        vector<string>      cmds;
+        vector<char const*> args;
+        for (size_t i = 0; i < names.size(); ++i)
+            cmds.push_back(prefix + names[i]);
+        args.push_back(libexe.c_str());
+        if (no_backup)
+            args.push_back("-n");
+        args.push_back(lib.c_str());
+        for (size_t i = 0; i < cmds.size(); ++i)
+            args.push_back(cmds[i].c_str());
+        args.push_back(NULL);
+        string rsp_opt;
+        fit_cmdline(args, rsp_opt);
+        print_args((char**)&args[0]);
+        return run_child("ar", args, string(), lib);
+    }
+
+    /// Make lib of the members of am by lib.exe -c, unless the link manifest says it has them.
+    int ar_flush(string const& lib, ArchiveMembers& am) {
+        vector<string> files(am.members());
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!file_exist(files[i].c_str())) {
+                fprintf(stderr, "%s: %s: member %s not found\n", fname_base(ccpath_), lib.c_str(), files[i].c_str());
+                return 1;
+            }
+        }
+        string              libexe = lib_exe();
+        vector<char const*> args;
+        args.push_back(libexe.c_str());
+        args.push_back("-c");
+        args.push_back("-n");
+        args.push_back(lib.c_str());
+        for (size_t i = 0; i < files.size(); ++i)
+            args.push_back(files[i].c_str());
+        args.push_back(NULL);
+        vector<string> inputs(files);
+        inputs.push_back(libexe);
+        LinkManifest lm(lib);
+        if (lm.up_to_date(&args[0], inputs)) {
+            if (verbose_)
+                fprintf(stderr, "%s: %s is up to date\n", fname_base(ccpath_), lib.c_str());
+        } else {
+            string rsp_opt;
+            fit_cmdline(args, rsp_opt);
+            print_args((char**)&args[0]);
+            int rc = run_child("ar", args, string(), lib);
+            if (rc != 0) {
+                lm.clear();
+                return rc;
+            }
+            lm.save();
+        }
+        am.set_pending(false);
+        return am.save() ? 0 : 1;
+    }
+
+    /// Make the archives of files with members left by dmc-ar. (before a link)
+    int complete_archives(vector<string> const& files) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            char const* ext = fname_ext(files[i].c_str());
+            if (strcmp(ext, ".lib") != 0 && strcmp(ext, ".LIB") != 0 && strcmp(ext, ".a") != 0)
+                continue;
+            ArchiveMembers am(files[i]);
+            if (am.load() && am.pending() && ar_flush(files[i], am) != 0)
+                return 1;
+        }
+        return 0;
+    }
+
+    /// -oFILE, or the first input with .exe (.dll by -WD)
+    string link_output(vector<string> const& inputs) const {
+        if (!out_opt_.empty())
+            return out_opt_.substr(2);
+        string out = inputs.empty() ? string("a") : inputs[0];
+        out.resize(out.size() - strlen(fname_ext(out.c_str())));
+        return out + (has_file(opts_, "-WD") ? ".dll" : ".exe");
+    }
+
+    /// Library directories in search order: -L/DIR, LIB, DMC/lib
+    void lib_dirs(vector<string>& dirs) const {
+        dirs.clear();
+        for (size_t i = 0; i < opts_.size(); ++i) {
+            if (opts_[i].compare(0, 3, "-L/") == 0 && opts_[i].size() > 3)
+                dirs.push_back(opts_[i].substr(3));
+        }
+        split_dirs(getenv("LIB"), dirs);
+        string dmcdir = bindir_.substr(0, bindir_.find_last_of("/\\", bindir_.size() - 2) + 1);
+        if (!dmcdir.empty())
+            dirs.push_back(dmcdir + "lib");
+    }
+
+    /** -lNAME -> libs_: the absolute path of libNAME.lib or NAME.lib in lib_dirs(),
+     *  first occurrence only. Not found ones are left to optlink as libNAME.lib.
+     *  A library that is only a member list of dmc-ar yet is found as well; the link makes it.
+     */
+    void resolve_libs(vector<string> const& names) {
+        vector<string> dirs;
+        lib_dirs(dirs);
+        LibIndex idx;
+        idx.set_cache_path(file_util::path_join(state_dir(), "libdirs.txt"));
+        for (size_t i = 0; i < names.size(); ++i) {
+            string path = idx.resolve(names[i], dirs);
+            if (path.empty()) {
+                if (verbose_)
+                    msg("Library %s not found\n", names[i].c_str());
+                path = "lib" + names[i] + ".lib";
+            }
+            if (!has_file(libs_, path))
+                libs_.push_back(path);
+        }
+        idx.save();
+    }
+
+    /// Path of lib in lib_dirs(). (lib itself if not found)
+    string find_lib(string const& lib) const {
+        if (file_exist(lib.c_str()))
+            return lib;
+        vector<string> dirs;
+        lib_dirs(dirs);
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            string path = file_util::path_join(dirs[i], lib);
+            if (file_exist(path.c_str()))
+                return path;
+        }
+        return lib;
+    }
+
+    /// Append the job compiling src to obj. (jobs must be reserved: args point into the strings of the job)
+    void add_job(vector<Job>& jobs, string const& src, string const& obj, string const& tmpbase) const {
+        jobs.push_back(Job());
+        Job& j = jobs.back();
+        char buf[16];
+        sprintf(buf, "%u", unsigned(jobs.size()));
+        j.src.assign(1, src);
+        j.obj     = obj;
+        j.obj_opt = "-o" + j.obj;
+        j.log     = tmpbase + buf + ".log";
+        if (!workers_.empty()) {
+            j.phase   = Job::PREPROCESS;
+            j.lst_opt = "-l" + tmpbase + buf + ".lst";
+        }
+        make_args(j.args, true, j.obj_opt, j.src, false);
+        if (j.phase == Job::PREPROCESS) {   // sppn OPTS(without the linker) -e -lLIST SRC
+            j.pre_args.assign(1, sppn_.c_str());
+            for (size_t i = 0; i < opts_.size(); ++i) {
+                if (strncmp(opts_[i].c_str(), "-L", 2) != 0)
+                    j.pre_args.push_back(opts_[i].c_str());
+            }
+            j.pre_args.push_back("-e");
+            j.pre_args.push_back(j.lst_opt.c_str());
+            j.pre_args.push_back(j.src[0].c_str());
+            j.pre_args.push_back(NULL);
+        }
+    }
+
+    void prune_job_includes(vector<Job>& jobs) {
+        TraceScope                   ts(trace_, "prune-includes");
+        vector<vector<char const*>*> args;
+        vector<string>               srcs;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            args.push_back(&jobs[i].args);
+            srcs.push_back(jobs[i].src[0]);
+            if (jobs[i].phase == Job::PREPROCESS) {
+                args.push_back(&jobs[i].pre_args);
+                srcs.push_back(jobs[i].src[0]);
+            }
+        }
+        prune_includes(args, srcs);
+    }
+
+    /** --CC-unity=K: group up to K sources of one language, in the given order, into
+     *  STATE_DIR/unity/HASH.c(pp) that #includes them, and add a job for each group.
+     *  The name is the hash of the contents, so the same group gets the same file
+     *  (and the same --CC-cache key). unity_job[i] is set to the job of files_[i].
+     */
+    bool make_unity_jobs(vector<Job>& jobs, vector<size_t>& unity_job, string const& tmpbase) {
+        string dir = file_util::path_join(state_dir(), "unity");
+        for (int cxx = 0; cxx < 2; ++cxx) {
+            vector<size_t> srcs;
+            for (size_t i = 0; i < files_.size(); ++i) {
+                char const* f = files_[i].c_str();
+                if (is_src_file(f) && (strcmp(fname_ext(f), ".c") != 0) == (cxx != 0)
+                    && !has_file(unity_excl_, files_[i]) && !has_file(unity_excl_, fname_base(f)))
+                {
+                    srcs.push_back(i);
+                }
+            }
+            for (size_t b = 0; b + 1 < srcs.size(); b += unity_) {
+                size_t e = (b + unity_ < srcs.size()) ? b + unity_ : srcs.size();
+                if (e - b < 2)
+                    break;
+                string text = "/* dmc-cc --CC-unity */\n";
+                for (size_t k = b; k < e; ++k)
+                    text += "#include \"" + file_util::full_path(files_[srcs[k]]) + "\"\n";
+                string path = file_util::path_join(dir, hash_util::fnv1a64().add(text).hex());
+                string src  = path + (cxx ? ".cpp" : ".c");
+                if (!file_exist(src.c_str())) {
+                    if (!file_util::make_dirs(dir) || !file_util::file_save_atomic(src.c_str(), text)) {
+                        fprintf(stderr, "%s: cannot write %s\n", fname_base(ccpath_), src.c_str());
+                        return false;
+                    }
+                }
+                add_job(jobs, src, path + ".obj", tmpbase);
+                for (size_t k = b; k < e; ++k) {
+                    jobs.back().members.push_back(srcs[k]);
+                    unity_job[srcs[k]] = jobs.size() - 1;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Objects to link. A unity object is put at its first source; a failed one is replaced by its sources' objects.
+    void get_link_objs(vector<Job> const& jobs, vector<size_t> const& unity_job, vector<string> const& objs
+                       , vector<string>& link_objs) const
+    {
+        link_objs.clear();
+        for (size_t i = 0; i < files_.size(); ++i) {
+            size_t u = unity_job[i];
+            if (u == size_t(-1) || (jobs[u].phase == Job::DONE && jobs[u].rc != 0))
+                link_objs.push_back(objs[i]);
+            else if (jobs[u].members[0] == i)
+                link_objs.push_back(jobs[u].obj);
+        }
+    }
+
+    /// Object of each file. (basename.obj, "_N" added on a collision. -o with -c)
+    void obj_names(vector<string>& objs) const {
+        objs.clear();
+        objs.reserve(files_.size());
+        for (size_t i = 0; i < files_.size(); ++i) {
+            char const* f = files_[i].c_str();
+            if (!is_src_file(f)) {
+                objs.push_back(files_[i]);
+            } else if (compile_only_ && !out_opt_.empty()) {
+                objs.push_back(out_opt_.substr(2));
+            } else {
+                string obj = fname_base(f);
+                obj.resize(obj.size() - strlen(fname_ext(f)));
+                string name = obj;
+                char   buf[16];
+                for (unsigned n = 2; has_file(objs, name + ".obj"); ++n) {
+                    sprintf(buf, "_%u", n);
+                    name = obj + buf;
+                }
+                objs.push_back(name + ".obj");
+            }
+        }
+    }
+
+    /// -MD/-MMD: write OBJ.d (or -MF FILE) for each source.
+    void write_deps(vector<string> const& objs) const {
+        vector<string> user_dirs, sys_dirs, forced;
+        include_dirs(user_dirs, sys_dirs, forced);
+        IncludeScanner sc;
+        sc.set_cache_path(file_util::path_join(state_dir(), "includes.txt"));
+        sc.set_dirs(user_dirs, sys_dirs);
+        bool one = count_sources() == 1;
+        vector<string> deps;
+        for (size_t i = 0; i < files_.size(); ++i) {
+            if (!is_src_file(files_[i].c_str()))
+                continue;
+            string const& obj  = objs[i];
+            string        path = dep_file_;
+            if (path.empty() || !one)
+                path = obj.substr(0, obj.size() - strlen(fname_ext(obj.c_str()))) + ".d";
+            sc.scan(files_[i], forced, dep_mode_ == DEP_USER, deps);
+            string targets = dep_targets_.empty() ? IncludeScanner::make_escape(obj) : dep_targets_;
+            if (!IncludeScanner::write_depfile(path.c_str(), targets, deps, dep_phony_))
+                fprintf(stderr, "%s: cannot write %s\n", fname_base(ccpath_), path.c_str());
+        }
+    }
+
+    /** -I directories, system (INCLUDE, dmc\include) directories and -HI files.
+     *  If opt_of is not NULL, it receives the opts_ index of each -I directory.
+     */
+    void include_dirs(vector<string>& user_dirs, vector<string>& sys_dirs, vector<string>& forced
+                      , vector<size_t>* opt_of = NULL) const
+    {
+        for (size_t i = 0; i < opts_.size(); ++i) {
+            string const& o = opts_[i];
+            if (o.compare(0, 3, "-HI") == 0 && o.size() > 3) {
+                forced.push_back(o.substr(3));
+            } else if (o.compare(0, 2, "-I") == 0) {
+                split_dirs(o.c_str() + 2, user_dirs);
+                if (opt_of)
+                    opt_of->resize(user_dirs.size(), i);
+            }
+        }
+        split_dirs(getenv("INCLUDE"), sys_dirs);
+        string dmcdir = bindir_.substr(0, bindir_.find_last_of("/\\", bindir_.size() - 2) + 1);
+        if (!dmcdir.empty())
+            sys_dirs.push_back(dmcdir + "include");
+    }
+
+    /** --CC-prune-includes: remove from args[k] the -I options that srcs[k] does not
+     *  find a header through. The kept ones stay in their order, so each header is
+     *  still found in the same directory. The result is kept in STATE_DIR/incdirs.txt
+     *  while the source, its headers, the -I directories, the directories a lookup tried
+     *  in vain (so a new "sub/x.h" in an earlier one is seen) and the options are the same.
+     *  A source with an #include of a macro keeps all of them.
+     */
+    void prune_includes(vector<vector<char const*>*> const& args, vector<string> const& srcs) {
+        vector<string> user_dirs, sys_dirs, forced;
+        vector<size_t> opt_of;
+        include_dirs(user_dirs, sys_dirs, forced, &opt_of);
+        if (user_dirs.empty())
+            return;
+        hash_util::fnv1a64 oh;
+        for (size_t i = 0; i < opts_.size(); ++i)
+            oh.add(opts_[i]);
+        IncludeScanner sc;
+        sc.set_cache_path(file_util::path_join(state_dir(), "includes.txt"));
+        sc.set_dirs(user_dirs, sys_dirs);
+        IncDirCache cache;
+        cache.set_path(file_util::path_join(state_dir(), "incdirs.txt"));
+        for (size_t k = 0; k < srcs.size(); ++k) {
+            string key = hash_util::fnv1a64(oh).add(file_util::full_path(srcs[k])).hex();
+            string used;
+            if (!cache.find(key, used)) {
+                vector<string> deps, dirs, misses;
+                sc.scan(srcs[k], forced, false, deps, &dirs, &misses);
+                vector<bool> use(opts_.size(), false);
+                for (size_t i = 0; i < dirs.size(); ++i) {
+                    for (size_t d = 0; d < user_dirs.size() && !dirs[i].empty(); ++d) {
+                        if (user_dirs[d] == dirs[i]) {
+                            use[opt_of[d]] = true;
+                            break;
+                        }
+                    }
+                }
+                char buf[16];
+                for (size_t i = 0; i < use.size(); ++i) {
+                    if (use[i]) {
+                        sprintf(buf, used.empty() ? "%u" : ",%u", unsigned(i));
+                        used += buf;
+                    }
+                }
+                if (sc.computed())
+                    used = "*";
+                deps.insert(deps.end(), user_dirs.begin(), user_dirs.end());
+                set<string> miss_dirs;
+                for (size_t i = 0; i < misses.size(); ++i)
+                    miss_dirs.insert(IncludeScanner::miss_dir(misses[i]));
+                deps.insert(deps.end(), miss_dirs.begin(), miss_dirs.end());
+                cache.add(key, used, deps);
+            }
+            if (used == "*")
+                continue;
+            string   list = "," + used + ",";
+            unsigned incs = 0, pruned = 0;
+            for (size_t i = 0; i < opts_.size(); ++i) {
+                if (opts_[i].compare(0, 2, "-I") != 0)
+                    continue;
+                ++incs;
+                char buf[16];
+                sprintf(buf, ",%u,", unsigned(i));
+                if (list.find(buf) != string::npos)
+                    continue;
+                vector<char const*>& a  = *args[k];
+                vector<char const*>::iterator it = std::find(a.begin(), a.end(), opts_[i].c_str());
+                if (it != a.end()) {
+                    a.erase(it);
+                    ++pruned;
+                }
+            }
+            if (verbose_ && pruned)
+                fprintf(stderr, "%s: %s: %u of %u -I not used\n", fname_base(ccpath_), srcs[k].c_str(), pruned, incs);
+        }
+    }
+
+    /// "DIR1;DIR2" -> dirs
+    static void split_dirs(char const* s, vector<string>& dirs, char sep = ';') {
+        while (s && *s) {
+            char const* e = strchr(s, sep);
+            if (e == NULL)
+                e = s + strlen(s);
+            if (e > s)
+                dirs.push_back(string(s, e));
+            s = *e ? e + 1 : e;
+        }
+    }
+
+    /// Directory for files kept between runs. (DMC_CC_STATE_DIR or TEMP/dmc-cc)
+    static string state_dir() {
+        char const* d = getenv("DMC_CC_STATE_DIR");
+        if (d && *d)
+            return d;
+        return proc_util::temp_dir() + "dmc-cc";
+    }
+
+    static bool has_file(vector<string> const& v, string const& s) {
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (v[i] == s)
+                return true;
+        }
+        return false;
+    }
+
+    /** Under a make jobserver, the first child runs on the implicit token and
+     *  each other one on a token taken from make. --CC-jobs=N (N > 1) still caps it.
+     */
+    int run_jobs(vector<Job>& jobs) {
+        size_t   n       = jobs.size();
+        size_t   slots   = (jobs_ < 64) ? jobs_ : 64;
+        if (js_.enabled() && jobs_ <= 1)
+            slots = 64;
+        vector<size_t> order;
+        job_order(jobs, slots > 1 && n > 1, order);
+        size_t   todo    = order.size();
+        size_t   next    = 0;
+        size_t   printed = 0;
+        size_t   running = 0;
+        int      rc      = 0;
+        vector<proc_util::proc_t> procs(slots);
+        vector<size_t>            slot_job(slots);
+        while (printed < n) {
+            for (size_t s = 0; s < slots && next < todo && running < slots; ++s) {
+                if (procs[s].running())
+                    continue;
+                if (js_.enabled() && running > js_.held() && !js_.acquire(0))
+                    break;
+                jobs[order[next]].slot = unsigned(s);
+                if (job_start(jobs[order[next]], procs[s])) {
+                    slot_job[s] = order[next];
+                    ++running;
+                }
+                ++next;
+            }
+            if (running) {
+                int code = 0;
+                proc_util::proc_usage_t u;
+                int s    = (js_.enabled() && next < todo && running < slots)
+                         ? wait_child_or_token(procs, code, u)
+                         : proc_util::proc_wait_any(&procs[0], slots, code, &u);
+                if (s == -2)
+                    continue;   // got a token for the next job.
+                if (s < 0)
+                    return 1;
+                --running;
+                Job& j = jobs[slot_job[s]];
+                if (job_exited(j, code, u) && job_start(j, procs[s]))
+                    ++running;
+            }
+            js_.release_to(running ? unsigned(running - 1) : 0);
+            while (printed < n && jobs[printed].phase == Job::DONE) {
+                Job& j = jobs[printed++];
+                if (j.rc != 0 && !j.members.empty())    // retried by each source.
+                    continue;
+                if (!j.out.empty()) {
+                    string out = native_diag_ ? j.out : DiagTranslator::translate(j.out);
+                    fwrite(out.data(), 1, out.size(), stdout);
+                    fflush(stdout);
+                }
+                if (j.rc != 0)
+                    rc = 1;
+            }
+        }
+        return rc;
+    }
+
+    /** The order to start jobs in, without the ones already done (by the cache).
+     *  With by_time, the ones without history come first, then the others by their
+     *  last compile time, longest first. (The output is still printed in the order of jobs.)
+     */
+    void job_order(vector<Job>& jobs, bool by_time, vector<size_t>& order) {
+        vector<pair<double, size_t> > v;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            Job& j = jobs[i];
+            if (j.phase == Job::DONE)
+                continue;
+            j.hkey = hash_util::fnv1a64().add(opts_hash()).add(file_util::full_path(j.src[0])).hex();
+            double ms = 0;
+            bool   known = by_time && history_.find(j.hkey, ms);
+            v.push_back(make_pair(known ? -ms : -1e300, i));
+        }
+        if (by_time)
+            stable_sort(v.begin(), v.end());
+        order.clear();
+        for (size_t i = 0; i < v.size(); ++i)
+            order.push_back(v[i].second);
+    }
+
+    /// Wait for a child to exit (@return its slot) or for a jobserver token (@return -2).
+    int wait_child_or_token(vector<proc_util::proc_t>& procs, int& code, proc_util::proc_usage_t& u) {
+        for (;;) {
+            for (size_t s = 0; s < procs.size(); ++s) {
+                if (procs[s].running() && proc_util::proc_try_wait(procs[s], code, &u))
+                    return int(s);
+            }
+            if (js_.acquire(10))
+                return -2;
+        }
+    }
+
+    /// Start the current phase of j. @return false if j is done.
+    bool job_start(Job& j, proc_util::proc_t& p) {
+        if (j.phase == Job::REMOTE)
+            remote_args(j);
+        vector<char const*>& a = (j.phase == Job::PREPROCESS) ? j.pre_args
+                               : (j.phase == Job::REMOTE) ? j.remote_args : j.args;
+        if (verbose_)
+            print_args((char**)&a[0]);
+        j.start = Tracer::now();
+        if (!j.begun)
+            j.begun = j.start;
+        if (proc_util::proc_start(&a[0], j.log.c_str(), p))
+            return true;
+        fprintf(stderr, "%s: cannot execute %s\n", fname_base(ccpath_), a[0]);
+        j.rc    = 1;
+        j.phase = Job::DONE;
+        return false;
+    }
+
+    /// The process of j exited with rc. @return true if j has a next phase.
+    bool job_exited(Job& j, int rc, proc_util::proc_usage_t const& u) {
+        static char const* const names[] = { "preprocess", "remote", "compile" };
+        trace_.span(names[j.phase], "dmc", j.start, Tracer::now(), j.src[0], j.slot + 1);
+        if (j.phase == Job::PREPROCESS) {
+            j.phase = Job::COMPILE;
+            if (rc == 0)
+                j.phase = Job::REMOTE;
+            else
+                remove(j.lst_opt.c_str() + 2);
+            return true;
+        }
+        char const* kind = "compile";
+        if (j.phase == Job::REMOTE) {
+            --worker_load_[j.worker];
+            remove(j.lst_opt.c_str() + 2);
+            if (rc != 0) {      // no worker, too slow, or the preprocessed source failed: the errors come from here.
+                j.phase = Job::COMPILE;
+                return true;
+            }
+            kind = "remote";
+        }
+        j.rc    = rc;
+        j.phase = Job::DONE;
+        log_stats(kind, j.src[0], j.obj, rc, j.start, u);
+        if (rc == 0)
+            history_.add(j.hkey, (Tracer::now() - j.begun) / 1000.0);
+        file_load(j.log.c_str(), j.out);
+        remove(j.log.c_str());
+        if (!j.key.empty()) {
+            cache_.count(false);
+            if (rc == 0 && files_stamp(j.key_files) == j.key_stamp)    // else a file changed while compiling.
+                cache_.put(j.key, j.obj.c_str(), j.out);
+        }
+        return false;
+    }
+
+    /** Flags for workers: opts_ without the ones used by the local preprocess, and the linker.
+     *  Without sppn.exe beside dmc.exe, or unless built with DMC_CC_REMOTE=1,
+     *  workers_ is cleared and all is compiled here.
+     */
+    void remote_setup() {
+        if (!DMC_CC_REMOTE) {
+            fprintf(stderr, "%s: --CC-workers is off in this build (DMC_CC_REMOTE=0), compiling without workers\n", fname_base(ccpath_));
+            workers_.clear();
+            return;
+        }
+        sppn_ = exepath_.substr(0, fname_base(exepath_.c_str()) - exepath_.c_str()) + "sppn.exe";
+        if (!file_exist(sppn_.c_str())) {
+            if (verbose_)
+                fprintf(stderr, "%s: no %s, compiling without workers\n", fname_base(ccpath_), sppn_.c_str());
+            workers_.clear();
+            return;
+        }
+        remote_flags_.clear();
+        for (size_t i = 0; i < opts_.size(); ++i) {
+            if (remote_flag_ok(opts_[i].c_str()))
+                remote_flags_.push_back(opts_[i]);
+        }
+        size_t n = 1;
+        for (size_t i = 0; i < workers_.size(); ++i)
+            n += workers_[i] == ',';
+        worker_load_.assign(n, 0);
+        self_path_ = proc_util::self_path(ccpath_);
+    }
+
+    /// Code generation options only. (also checked by the worker)
+    static bool remote_flag_ok(char const* f) {
+        if (f[0] != '-')
+            return false;
+        switch (f[1]) {
+        case 'o':
+            return f[2] == '+' || f[2] == '-';
+        case 'I': case 'D': case 'U': case 'H': case 'L': case 'l': case 'e': case 'c': case 'v':
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    /// Args of dmc-cc --CC-remote for j, starting with the least loaded worker.
+    void remote_args(Job& j) {
+        vector<string> ws;
+        split_dirs(workers_.c_str(), ws, ',');
+        size_t best = 0;
+        for (size_t i = 1; i < ws.size() && i < worker_load_.size(); ++i) {
+            if (worker_load_[i] < worker_load_[best])
+                best = i;
+        }
+        ++worker_load_[best];
+        j.worker = int(best);
+        j.remote_workers.clear();
+        for (size_t i = 0; i < ws.size(); ++i) {
+            if (i)
+                j.remote_workers += ',';
+            j.remote_workers += ws[(best + i) % ws.size()];
+        }
+        j.remote_args.clear();
+        j.remote_args.push_back(self_path_.c_str());
+        j.remote_args.push_back("--CC-remote");
+        j.remote_args.push_back(j.lst_opt.c_str() + 2);
+        j.remote_args.push_back(j.obj.c_str());
+        j.remote_args.push_back(fname_ext(j.src[0].c_str()));
+        j.remote_args.push_back(j.remote_workers.c_str());
+        for (size_t i = 0; i < remote_flags_.size(); ++i)
+            j.remote_args.push_back(remote_flags_[i].c_str());
+        j.remote_args.push_back(NULL);
+    }
+
+    /** dmc-cc --CC-remote LIST OBJ EXT WORKERS FLAGS...
+     *  Send the preprocessed LIST to the first worker that is not busy, and write OBJ.
+     *  @return the rc of dmc, or DMC_CC_REMOTE_RETRY if no worker did it in time.
+     */
+    int remote_main(int argc, char* argv[]) {
+        string text;
+        if (argc < 6 || !file_load(argv[2], text))
+            return DMC_CC_REMOTE_RETRY;
+        string         secret = shared_secret();
+        vector<string> req;
+        req.push_back("compile");
+        req.push_back(argv[4]);
+        req.push_back(text);
+        for (int i = 6; i < argc; ++i)
+            req.push_back(argv[i]);
+        char const* t       = getenv("DMC_CC_WORKER_TIMEOUT");
+        unsigned    timeout = (t && *t) ? strz_to<unsigned>(t) : 60000;
+        vector<string> ws;
+        split_dirs(argv[5], ws, ',');
+        for (size_t i = 0; i < ws.size(); ++i) {
+            string          host;
+            unsigned short  port = 0;
+            char            num[16];
+            sprintf(num, ":%u", DMC_CC_WORKER_PORT);
+            if (ws[i].find(':') == string::npos)
+                ws[i] += num;
+            if (!net_util::parse_host_port(ws[i].c_str(), host, port))
+                continue;
+            net_util::socket_t s = net_util::tcp_connect(host.c_str(), port);
+            if (!net_util::sock_valid(s))
+                continue;
+            vector<string> res;
+            bool ok = net_util::sock_set_timeout(s, timeout) && auth_client(s, secret)
+                   && net_util::send_strs(s, req) && net_util::recv_strs(s, res);
+            net_util::sock_close(s);
+            if (!ok || res.size() < 4 || res[0] != "ok")
+                continue;       // busy, failed or not proving the secret.
+            int rc = atoi(res[1].c_str());
+            if (rc == 0 && !file_util::file_save_atomic(argv[3], res[3]))
+                return DMC_CC_REMOTE_RETRY;
+            fwrite(res[2].data(), 1, res[2].size(), stdout);
+            return rc ? 1 : 0;
+        }
+        return DMC_CC_REMOTE_RETRY;
+    }
+
+    /** dmc-cc --CC-worker[=[HOST:]PORT]
+     *  Compile preprocessed sources for --CC-remote, up to the number of cpus at a time.
+     *  Requests over that are answered "busy", so that the client tries another worker.
+     *  Only loopback unless DMC_CC_SECRET is set. Like --CC-server, clients are read
+     *  DMC_CC_SERVER_CONNS at a time, and only after the handshake (auth_server) the
+     *  request, of at most 64 MB.
+     */
+    int worker_main(char const* opt) {
+        string          host;
+        unsigned short  port = 0;
+        if (!net_util::parse_host_port((opt[11] == '=') ? opt + 12 : NULL, host, port)) {
+            host = "127.0.0.1";
+            port = DMC_CC_WORKER_PORT;
+        }
+        string secret;
+        if (!secret_ok(host, secret))
+            return 1;
+        net_util::socket_t ls = net_util::tcp_listen(host.c_str(), port);
+        if (!net_util::sock_valid(ls)) {
+            fprintf(stderr, "%s: cannot listen %s:%u\n", fname_base(ccpath_), host.c_str(), port);
+            return 1;
+        }
+        char const* tc = getenv("DMC_CC_TOOLCHAIN");
+        if (!get_exepath(ccpath_, tc ? tc : ""))
+            return 1;
+        unsigned slots = proc_util::cpu_count();
+        printf("%s: worker %s:%u (%u slots)\n", fname_base(ccpath_), host.c_str(), port, slots);
+        fflush(stdout);
+
+        string tmpbase = proc_util::temp_dir();
+        char   buf[64];
+        sprintf(buf, "dmc-cc-w%u-", proc_util::get_pid());
+        tmpbase += buf;
+        vector<WorkerTask>          tasks;
+        vector<ServerConn>          conns;
+        vector<net_util::socket_t>  socks;
+        vector<char>                ready;
+        unsigned                    seq  = 0;
+        bool                        stop = false;
+        while (!stop || !tasks.empty()) {
+            for (size_t i = 0; i < tasks.size(); ) {
+                int rc = 0;
+                if (stop)
+                    rc = proc_util::proc_wait(tasks[i].proc);
+                else if (!proc_util::proc_try_wait(tasks[i].proc, rc)) {
+                    ++i;
+                    continue;
+                }
+                worker_reply(tasks[i], rc);
+                tasks.erase(tasks.begin() + i);
+            }
+            if (stop)
+                continue;
+            socks.assign(1, ls);
+            for (size_t i = 0; i < conns.size(); ++i)
+                socks.push_back(conns[i].sock);
+            if (net_util::wait_readable_any(&socks[0], socks.size(), tasks.empty() ? 1000 : 10, ready) < 0)
+                continue;
+            Tracer::time_type now = Tracer::now();
+            for (size_t i = conns.size(); i-- > 0;) {
+                ServerConn&    c = conns[i];
+                vector<string> req;
+                int            r = 0;
+                if (ready[i + 1]) {
+                    long n = net_util::recv_some(c.sock, c.buf);
+                    r = (n > 0) ? auth_server(c, secret) : -1;
+                    if (r > 0)
+                        r = (c.buf.size() <= 0x4000000) ? net_util::parse_strs(c.buf, req) : -1;
+                    c.since = now;
+                } else if (now - c.since > DMC_CC_SERVER_IDLE * 1000ULL) {
+                    r = -1;
+                }
+                if (r > 0 && worker_request(req, c.sock, tasks, slots, tmpbase, seq, stop))
+                    c.sock = net_util::invalid_socket();    // the task answers it.
+                if (r != 0) {
+                    net_util::sock_close(c.sock);
+                    conns.erase(conns.begin() + i);
+                }
+            }
+            if (ready[0]) {
+                ServerConn c;
+                c.sock  = net_util::tcp_accept(ls);
+                c.since = now;
+                if (net_util::sock_valid(c.sock) && conns.size() < DMC_CC_SERVER_CONNS) {
+                    net_util::sock_set_timeout(c.sock, 30000);     // for the replies.
+                    conns.push_back(c);
+                } else {
+                    net_util::sock_close(c.sock);
+                }
+            }
+        }
+        for (size_t i = 0; i < conns.size(); ++i)
+            net_util::sock_close(conns[i].sock);
+        net_util::sock_close(ls);
         return 0;
     }
 
+    /** Answer req of an authenticated client on s: "stop", or "compile" EXT TEXT FLAGS...
+     *  @return true if a task is started for it. (the task answers s when it ends)
+     */
+    bool worker_request(vector<string> const& req, net_util::socket_t s, vector<WorkerTask>& tasks, unsigned slots
+                        , string const& tmpbase, unsigned& seq, bool& stop)
+    {
+        vector<string> res;
+        if (req.size() == 1 && req[0] == "stop") {
+            stop = true;
+            res.push_back("ok");
+        } else if (req.size() < 3 || req[0] != "compile") {
+            res.push_back("error");
+        } else if (tasks.size() >= slots) {
+            res.push_back("busy");
+        } else {
+            WorkerTask t;
+            char       buf[16];
+            t.sock = s;
+            sprintf(buf, "%u", ++seq);
+            string ext = is_src_file(("a" + req[1]).c_str()) ? req[1] : string(".c");
+            t.src = tmpbase + buf + ext;
+            t.obj = tmpbase + buf + ".obj";
+            t.log = tmpbase + buf + ".log";
+            string              obj_opt = "-o" + t.obj;
+            vector<char const*> a;
+            a.push_back(exepath_.c_str());
+            for (size_t i = 3; i < req.size(); ++i) {
+                if (remote_flag_ok(req[i].c_str()))
+                    a.push_back(req[i].c_str());
+            }
+            a.push_back("-c");
+            a.push_back(obj_opt.c_str());
+            a.push_back(t.src.c_str());
+            a.push_back(NULL);
+            if (file_util::file_save_atomic(t.src.c_str(), req[2]) && proc_util::proc_start(&a[0], t.log.c_str(), t.proc)) {
+                tasks.push_back(t);
+                return true;
+            }
+            remove(t.src.c_str());
+            res.push_back("error");
+        }
+        net_util::send_strs(s, res);
+        return false;
+    }
+
+    /// Send ok, rc, output and the object of t.
+    static void worker_reply(WorkerTask& t, int rc) {
+        vector<string> res(4);
+        res[0] = "ok";
+        char buf[16];
+        sprintf(buf, "%d", rc);
+        res[1] = buf;
+        file_util::file_read(t.log.c_str(), res[2]);
+        if (rc == 0 && !file_util::file_read(t.obj.c_str(), res[3]))
+            res[0] = "error";
+        net_util::send_strs(t.sock, res);
+        net_util::sock_close(t.sock);
+        remove(t.src.c_str());
+        remove(t.obj.c_str());
+        remove(t.log.c_str());
+    }
+
+    /// dmc-cc --CC-worker-stop[=[HOST:]PORT]
+    int worker_stop(char const* opt) {
+        string          host;
+        unsigned short  port = 0;
+        if (!net_util::parse_host_port((opt[16] == '=') ? opt + 17 : NULL, host, port)) {
+            host = "127.0.0.1";
+            port = DMC_CC_WORKER_PORT;
+        }
+        net_util::socket_t s = net_util::tcp_connect(host.c_str(), port);
+        if (!net_util::sock_valid(s))
+            return 1;
+        vector<string> req(1, "stop"), res;
+        bool ok = net_util::sock_set_timeout(s, 30000);
+        if (ok && !auth_client(s, shared_secret()))
+            res.assign(1, "denied");
+        else
+            ok = ok && net_util::send_strs(s, req) && net_util::recv_strs(s, res);
+        net_util::sock_close(s);
+        if (ok && (res.empty() || res[0] != "ok")) {
+            fprintf(stderr, "%s: the worker refused. (DMC_CC_SECRET or DMC_CC_STATE_DIR differs)\n", fname_base(ccpath_));
+            return 1;
+        }
+        return ok ? 0 : 1;
+    }
+
+    /** If the command line of args is longer than DMC_CC_CMDLINE_MAX, pass opts_
+     *  by @RSP, and if still too long, all the arguments (not nesting the @RSP of opts_).
+     *  rsp_opt keeps the latter. The response files are named by their contents,
+     *  so invocations with the same options share one.
+     */
+    void fit_cmdline(vector<char const*>& args, string& rsp_opt) {
+        if (cmdline_size(args) <= DMC_CC_CMDLINE_MAX)
+            return;
+        vector<char const*> all(args);
+        size_t n = opts_.size();
+        if (n > 1 && args.size() > n + 1 && args[1] == opts_[0].c_str() && args[n] == opts_[n - 1].c_str()) {
+            if (opts_rsp_.empty())
+                opts_rsp_ = make_rsp(&args[1], &args[1] + n);
+            if (!opts_rsp_.empty()) {
+                args.erase(args.begin() + 2, args.begin() + 1 + n);
+                args[1] = opts_rsp_.c_str();
+            }
+        }
+        if (cmdline_size(args) <= DMC_CC_CMDLINE_MAX)
+            return;
+        rsp_opt = make_rsp(&all[1], &all[0] + all.size() - 1);
+        if (!rsp_opt.empty()) {
+            args.resize(1);
+            args.push_back(rsp_opt.c_str());
+            args.push_back(NULL);
+        }
+    }
+
+    /// Length of the command line made from args. (NULL terminated)
+    static size_t cmdline_size(vector<char const*> const& args) {
+        string line;
+        for (size_t i = 0; i < args.size() && args[i]; ++i) {
+            proc_util::append_quoted_arg(line, args[i]);
+            line += ' ';
+        }
+        return line.size();
+    }
+
+    /// Write [b,e) to STATE_DIR/rsp/HASH.rsp, one argument per line. (append_response_arg) @return "@PATH" or "" on error.
+    string make_rsp(char const* const* b, char const* const* e) const {
+        string text;
+        for (; b != e; ++b) {
+            append_response_arg(text, *b);
+            text += '\n';
+        }
+        string dir  = file_util::path_join(state_dir(), "rsp");
+        string path = file_util::path_join(dir, hash_util::fnv1a64().add(text).hex() + ".rsp");
+        if (!file_exist(path.c_str())) {
+            if (!file_util::make_dirs(dir) || !file_util::file_save_atomic(path.c_str(), text)) {
+                fprintf(stderr, "%s: cannot write %s\n", fname_base(ccpath_), path.c_str());
+                return string();
+            }
+        }
+        return "@" + path;
+    }
+
+    /// Set the cache key of each job, and finish the ones whose object is in the cache.
+    void cache_lookup(vector<Job>& jobs) {
+        TraceScope     ts(trace_, "cache-lookup");
+        vector<string> user_dirs, sys_dirs, forced;
+        include_dirs(user_dirs, sys_dirs, forced);
+        IncludeScanner sc;
+        sc.set_cache_path(file_util::path_join(state_dir(), "includes.txt"));
+        sc.set_dirs(user_dirs, sys_dirs);
+        map<string, string> sums;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            Job& j = jobs[i];
+            j.key = cache_key(sc, j.src[0], forced, sums, j.key_files);
+            if (j.key.empty())
+                continue;
+            j.key_stamp = files_stamp(j.key_files);
+            if (cache_.get(j.key, j.obj.c_str(), j.out)) {
+                cache_.count(true);
+                j.rc    = 0;
+                j.phase = Job::DONE;
+            }
+        }
+    }
+
+    /** Hash of the compiler, the options, the full path and contents of src and of
+     *  each header the #include scanner finds for it (system ones too), and the paths
+     *  the lookups tried before them that did not exist. files receives all of them,
+     *  so that a header made at one of the latter while compiling is seen by files_stamp.
+     *  "" (not cached) if src has an #include of a macro or a file cannot be read.
+     *  sums keeps the hash of the contents of each file read.
+     */
+    string cache_key(IncludeScanner& sc, string const& src, vector<string> const& forced
+                     , map<string, string>& sums, vector<string>& files) const
+    {
+        vector<string> misses;
+        sc.scan(src, forced, false, files, NULL, &misses);
+        if (sc.computed())
+            return string();
+        hash_util::fnv1a128    h;
+        file_util::file_stat_t st;
+        file_util::file_stat(exepath_.c_str(), st);
+        h.add("dmc-cc cache 3").add(exepath_).add_u64(st.size).add_u64(st.mtime);
+        for (size_t i = 0; i < opts_.size(); ++i)
+            h.add(opts_[i]);
+        h.add("-c");
+        h.add_u64(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            string& sum = sums[files[i]];
+            if (sum.empty()) {
+                string text;
+                if (!file_util::file_read(files[i].c_str(), text))
+                    return string();
+                sum = hash_util::fnv1a128().add(text.data(), text.size()).hex();
+            }
+            h.add(file_util::full_path(files[i])).add(sum);
+        }
+        h.add_u64(misses.size());
+        for (size_t i = 0; i < misses.size(); ++i)
+            h.add(file_util::full_path(misses[i]));
+        files.insert(files.end(), misses.begin(), misses.end());
+        return h.hex();
+    }
+
+    /// Hash of the size and mtime of files.
+    static string files_stamp(vector<string> const& files) {
+        hash_util::fnv1a64 h;
+        for (size_t i = 0; i < files.size(); ++i) {
+            file_util::file_stat_t st;
+            file_util::file_stat(files[i].c_str(), st);
+            h.add(files[i]).add_u64(st.size).add_u64(st.mtime);
+        }
+        return h.hex();
+    }
+
     int print_args(char** dst_argv) {
         if (print_args_) {
             for (size_t i = 0; dst_argv[i]; ++i)
-                printf("argv[%d]=%s\n", i, dst_args_[i]);
+                printf("argv[%d]=%s\n", int(i), dst_argv[i]);
             return 0;
         }
         if (verbose_) {
@@ -305,54 +2685,16 @@ private:
         printf("      Convert and pass gcc-like command line arguments to dmc.\n"
                "      Filename convert '/' to '\\'.\n"
                "  @FILE     Input response FILE.\n"
-               "  --help    Help.\n"
-               "  --NATIVE  Afterwards dmc option.\n"
-               "  --GCC     Afterwards gcc option.\n"
-               " (gcc)                   (dmc)\n"
-               "  --define-macro M[=S]    -D[M[=S]]\n"
-               "  -D[MACRO[=STR]]         -D[MACRO[=STR]]\n"
-               "  --undefine-macro MACRO  -U[MACRO]\n"
-               "  -U[MACRO]               -U[MACRO]\n"
-               "  --include-directory DIR -I[DIR]\n"
-               "  -I DIR                  -I[DIR]\n"
-               "  --include FILE          -HI[FILE]\n"
-               "  --output FILE           -o[FILE]\n"
-               "  -o FILE                 -o[FILE]\n"
-               "  --library NAME          lib[NAME].lib\n"
-               "  -l NAME                 lib[NAME].lib\n"
-               "  --library-path DIR      -L/DIR\n"
-               "  -L DIR                  -L/DIR\n"
-               "  -S                      -cod\n"
-               "  -shared                 -WD\n"
-               "  -mdll                   -WD\n"
-               "  --debug                 -g\n"
-               "  -g                      -g\n"
-               "  -Wall                   -w\n"
-               "  -Werror                 -wx\n"
-               "  -O0                     -o+none\n"
-               "  -O1 -O2 -O3             -o+all\n"
-               "  -Ofast                  -o+speed\n"
-               "  -Os                     -o+space\n"
-               "  -Oz                     -o+space\n"
-               "  --std=c++??             -cpp\n"
-               "  --std=gnu++??           -cpp\n"
-               "  --std=c??               \n"
-               "  --std=gnu??             \n"
-               "  -frtti                  -Ar\n"
-               "  -fexceptions            -Ae\n"
-               "  -funsigned-char         -J\n"
-               "  -fsigned-char           \n"
-               "  -fstack-check-generic   -s\n"
-               "  -fstack-check-specific  -s\n"
-               "  --ansi                  -A\n"
-               "  -v                      -v1\n"
         );
+        print_opt_help(stdout);
         return 1;
     }
 };
 
 
-int main(int argc, char* argv[], char** env) {
-    int rc = Program().main(argc, argv, env);
+#if !defined(DMC_CC_NO_MAIN)
+int main(int argc, char* argv[]) {
+    int rc = Program().main(argc, argv);
     return rc;
 }
+#endif
@@ -0,0 +1,373 @@
+/**
+ *  @file   file_util.hpp
+ *  @brief  File and directory helpers.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    Writes by file_save_atomic() and file_append() are safe against
+ *    concurrent processes (e.g. make -j).
+ */
+#ifndef ZATU_FILE_UTIL_HPP_INCLUDED
+#define ZATU_FILE_UTIL_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#endif
+
+namespace zatu {
+namespace file_util {
+
+#if defined(_WIN32)
+enum { path_sep = '\\' };
+#else
+enum { path_sep = '/' };
+#endif
+
+/// Size and modification stamp of a file.
+struct file_stat_t {
+    unsigned long long  size;
+    unsigned long long  mtime;      // opaque, only for comparison.
+    bool                is_dir;
+    file_stat_t() : size(0), mtime(0), is_dir(false) {}
+};
+
+inline bool file_stat(char const* path, file_stat_t& st) {
+ #if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA a;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &a))
+        return false;
+    st.size   = (unsigned long long)a.nFileSizeHigh << 32 | a.nFileSizeLow;
+    st.mtime  = (unsigned long long)a.ftLastWriteTime.dwHighDateTime << 32 | a.ftLastWriteTime.dwLowDateTime;
+    st.is_dir = (a.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+ #else
+    struct stat s;
+    if (::stat(path, &s) != 0)
+        return false;
+    st.size   = (unsigned long long)s.st_size;
+   #if defined(__linux__)
+    st.mtime  = (unsigned long long)s.st_mtim.tv_sec * 1000000000ULL + s.st_mtim.tv_nsec;
+   #else
+    st.mtime  = (unsigned long long)s.st_mtime;
+   #endif
+    st.is_dir = S_ISDIR(s.st_mode);
+ #endif
+    return true;
+}
+
+inline bool is_dir(char const* path) {
+    file_stat_t st;
+    return file_stat(path, st) && st.is_dir;
+}
+
+inline std::string get_cwd() {
+    char buf[4096] = {0};
+ #if defined(_WIN32)
+    DWORD n = GetCurrentDirectoryA(sizeof buf, buf);
+    return std::string(buf, (n < sizeof buf) ? n : 0);
+ #else
+    return ::getcwd(buf, sizeof buf) ? std::string(buf) : std::string();
+ #endif
+}
+
+inline bool set_cwd(char const* dir) {
+ #if defined(_WIN32)
+    return SetCurrentDirectoryA(dir) != 0;
+ #else
+    return ::chdir(dir) == 0;
+ #endif
+}
+
+/// "dir" + sep + "name"
+inline std::string path_join(std::string const& dir, std::string const& name) {
+    if (dir.empty())
+        return name;
+    char c = dir[dir.size() - 1];
+    if (c == '/' || c == '\\' || c == ':')
+        return dir + name;
+    return dir + char(path_sep) + name;
+}
+
+/// path made absolute by the current directory.
+inline std::string full_path(std::string const& path) {
+    if (!path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':')))
+        return path;
+    return path_join(get_cwd(), path);
+}
+
+/// path without "." and "dir/.." segments and repeated separators, joined by sep.
+inline std::string normalize_path(std::string const& path, char sep = char(path_sep)) {
+    std::string pre;
+    std::size_t i = 0;
+    if (path.size() > 1 && path[1] == ':') {
+        pre = path.substr(0, 2);
+        i   = 2;
+    }
+    bool root = i < path.size() && (path[i] == '/' || path[i] == '\\');
+    if (root) {
+        pre += sep;
+        if (i == 0 && path.size() > 1 && (path[1] == '/' || path[1] == '\\'))
+            pre += sep;     // \\server\share
+    }
+    std::vector<std::string> segs;
+    while (i < path.size()) {
+        std::size_t e = path.find_first_of("/\\", i);
+        if (e == std::string::npos)
+            e = path.size();
+        std::string seg = path.substr(i, e - i);
+        i = e + 1;
+        if (seg.empty() || seg == ".")
+            continue;
+        if (seg == ".." && !segs.empty() && segs.back() != "..")
+            segs.pop_back();
+        else if (seg != ".." || !root)
+            segs.push_back(seg);
+    }
+    std::string r = pre;
+    for (std::size_t k = 0; k < segs.size(); ++k) {
+        if (k)
+            r += sep;
+        r += segs[k];
+    }
+    return r.empty() ? std::string(".") : r;
+}
+
+/// Names of the files (not directories) in dir.
+inline bool list_dir(std::string const& dir, std::vector<std::string>& names) {
+    names.clear();
+ #if defined(_WIN32)
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(path_join(dir, "*").c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            names.push_back(fd.cFileName);
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+ #else
+    DIR* d = ::opendir(dir.c_str());
+    if (d == NULL)
+        return false;
+    while (dirent* e = ::readdir(d)) {
+        if (!is_dir(path_join(dir, e->d_name).c_str()))
+            names.push_back(e->d_name);
+    }
+    ::closedir(d);
+ #endif
+    return true;
+}
+
+/// mkdir -p
+inline bool make_dirs(std::string const& path) {
+    if (path.empty() || is_dir(path.c_str()))
+        return true;
+    std::size_t p = path.find_last_of("/\\");
+    if (p != std::string::npos && p > 0 && path[p - 1] != ':')
+        make_dirs(path.substr(0, p));
+ #if defined(_WIN32)
+    CreateDirectoryA(path.c_str(), NULL);
+ #else
+    ::mkdir(path.c_str(), 0777);
+ #endif
+    return is_dir(path.c_str());
+}
+
+/// Rename src to dst, replacing dst.
+inline bool file_rename(char const* src, char const* dst) {
+ #if defined(_WIN32)
+    return MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING) != 0;
+ #else
+    return ::rename(src, dst) == 0;
+ #endif
+}
+
+/// Write to a temporary file beside path, then rename it to path.
+inline bool file_save_atomic(char const* path, void const* data, std::size_t size) {
+    char buf[32];
+ #if defined(_WIN32)
+    std::sprintf(buf, ".%lu.tmp", (unsigned long)GetCurrentProcessId());
+ #else
+    std::sprintf(buf, ".%lu.tmp", (unsigned long)getpid());
+ #endif
+    std::string tmp = std::string(path) + buf;
+    FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if (!fp)
+        return false;
+    bool rc = (size == 0) || std::fwrite(data, 1, size, fp) == size;
+    rc &= std::fclose(fp) == 0;
+    if (rc)
+        rc = file_rename(tmp.c_str(), path);
+    if (!rc)
+        std::remove(tmp.c_str());
+    return rc;
+}
+
+inline bool file_save_atomic(char const* path, std::string const& s) {
+    return file_save_atomic(path, s.data(), s.size());
+}
+
+/// Create path with s, only if path does not exist. (no one sees it half written)
+inline bool file_save_new(char const* path, std::string const& s) {
+    char buf[32];
+ #if defined(_WIN32)
+    std::sprintf(buf, ".%lu.new", (unsigned long)GetCurrentProcessId());
+ #else
+    std::sprintf(buf, ".%lu.new", (unsigned long)getpid());
+ #endif
+    std::string tmp = std::string(path) + buf;
+    FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if (!fp)
+        return false;
+    bool rc = s.empty() || std::fwrite(s.data(), 1, s.size(), fp) == s.size();
+    rc &= std::fclose(fp) == 0;
+ #if defined(_WIN32)
+    rc = rc && MoveFileExA(tmp.c_str(), path, 0) != 0;
+ #else
+    rc = rc && ::link(tmp.c_str(), path) == 0;
+ #endif
+    std::remove(tmp.c_str());
+    return rc;
+}
+
+/// Append data to path with one write. (O_APPEND / FILE_APPEND_DATA)
+inline bool file_append(char const* path, void const* data, std::size_t size) {
+ #if defined(_WIN32)
+    HANDLE h = CreateFileA(path, FILE_APPEND_DATA, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE
+                           , NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    DWORD n = 0;
+    BOOL ok = WriteFile(h, data, DWORD(size), &n, NULL);
+    CloseHandle(h);
+    return ok && n == size;
+ #else
+    int fd = ::open(path, O_WRONLY|O_CREAT|O_APPEND, 0666);
+    if (fd == -1)
+        return false;
+    ssize_t n = ::write(fd, data, size);
+    ::close(fd);
+    return n == ssize_t(size);
+ #endif
+}
+
+inline bool file_append(char const* path, std::string const& s) {
+    return file_append(path, s.data(), s.size());
+}
+
+/// Load whole file.
+inline bool file_read(char const* path, std::string& s) {
+    s.clear();
+    FILE* fp = std::fopen(path, "rb");
+    if (!fp)
+        return false;
+    char   buf[0x4000];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof buf, fp)) > 0)
+        s.append(buf, n);
+    bool rc = !std::ferror(fp);
+    std::fclose(fp);
+    return rc;
+}
+
+/// Copy src to dst. (dst is replaced atomically)
+inline bool file_copy(char const* src, char const* dst) {
+    std::string s;
+    return file_read(src, s) && file_save_atomic(dst, s);
+}
+
+/// Read-only view of a whole file. (MapViewOfFile / mmap)
+class mapped_file {
+public:
+    mapped_file() : data_(NULL), size_(0), open_(false) {}
+    explicit mapped_file(char const* path) : data_(NULL), size_(0), open_(false) { open(path); }
+    ~mapped_file() { close(); }
+
+    bool open(char const* path) {
+        close();
+     #if defined(_WIN32)
+        HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_DELETE, NULL
+                               , OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (h == INVALID_HANDLE_VALUE)
+            return false;
+        DWORD hi = 0;
+        DWORD lo = GetFileSize(h, &hi);
+        size_ = std::size_t((unsigned long long)hi << 32 | lo);
+        if (size_ > 0) {
+            HANDLE m = CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (m) {
+                data_ = (char const*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(m);
+            }
+        }
+        CloseHandle(h);
+     #else
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1)
+            return false;
+        struct stat st;
+        size_ = (::fstat(fd, &st) == 0) ? std::size_t(st.st_size) : 0;
+        if (size_ > 0) {
+            void* p = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            data_ = (p != MAP_FAILED) ? (char const*)p : NULL;
+        }
+        ::close(fd);
+     #endif
+        if (size_ > 0 && data_ == NULL)
+            size_ = 0;
+        else
+            open_ = true;
+        return open_;
+    }
+
+    void close() {
+        if (data_) {
+         #if defined(_WIN32)
+            UnmapViewOfFile(data_);
+         #else
+            ::munmap((void*)data_, size_);
+         #endif
+        }
+        data_ = NULL;
+        size_ = 0;
+        open_ = false;
+    }
+
+    bool        is_open() const { return open_; }
+    char const* begin() const { return data_; }
+    char const* end() const { return data_ + size_; }
+    std::size_t size() const { return size_; }
+
+private:
+    mapped_file(mapped_file const&);
+    mapped_file& operator=(mapped_file const&);
+
+private:
+    char const* data_;
+    std::size_t size_;
+    bool        open_;
+};
+
+}   // file_util
+}   // zatu
+
+#endif  // ZATU_FILE_UTIL_HPP_INCLUDED
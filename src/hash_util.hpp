@@ -0,0 +1,240 @@
+/**
+ *  @file   hash_util.hpp
+ *  @brief  Non-cryptographic hashes for cache keys, and SHA-256 / HMAC for authentication.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *
+ *  ex)
+ *    hash_util::fnv1a64 h;
+ *    h.add(text.data(), text.size()).add("-o+all");
+ *    std::string key = h.hex();
+ */
+#ifndef ZATU_HASH_UTIL_HPP_INCLUDED
+#define ZATU_HASH_UTIL_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace zatu {
+namespace hash_util {
+
+/// FNV-1a 64bit.
+class fnv1a64 {
+public:
+    typedef unsigned long long value_type;
+
+    fnv1a64() : h_(0xcbf29ce484222325ULL) {}
+
+    fnv1a64& add(void const* data, std::size_t size) {
+        unsigned char const* p = (unsigned char const*)data;
+        unsigned char const* e = p + size;
+        value_type           h = h_;
+        while (p < e) {
+            h ^= *p++;
+            h *= 0x100000001b3ULL;
+        }
+        h_ = h;
+        return *this;
+    }
+
+    /// Add s with its '\0', so that "ab","c" and "a","bc" differ.
+    fnv1a64& add(char const* s) { return add(s, std::strlen(s) + 1); }
+    fnv1a64& add(std::string const& s) { return add(s.c_str(), s.size() + 1); }
+
+    fnv1a64& add_u64(value_type v) {
+        unsigned char b[8];
+        for (int i = 0; i < 8; ++i)
+            b[i] = (unsigned char)(v >> (i * 8));
+        return add(b, 8);
+    }
+
+    value_type  value() const { return h_; }
+
+    std::string hex() const { return to_hex(h_); }
+
+    static std::string to_hex(value_type v) {
+        char buf[20];
+        std::sprintf(buf, "%08x%08x", unsigned(v >> 32), unsigned(v));
+        return std::string(buf);
+    }
+
+private:
+    value_type  h_;
+};
+
+/// FNV-1a 128bit. For keys that stand for a compile, where a collision would give a wrong result.
+class fnv1a128 {
+public:
+    typedef unsigned long long u64;
+
+    fnv1a128() : hi_(0x6c62272e07bb0142ULL), lo_(0x62b821756295c58dULL) {}
+
+    /// h *= 2^88 + 0x13b, as (h << 88) + h * 0x13b.
+    fnv1a128& add(void const* data, std::size_t size) {
+        unsigned char const* p  = (unsigned char const*)data;
+        unsigned char const* e  = p + size;
+        u64                  hi = hi_;
+        u64                  lo = lo_;
+        while (p < e) {
+            lo ^= *p++;
+            u64 m0 = (lo & 0xffffffffULL) * 0x13b;
+            u64 m1 = (lo >> 32) * 0x13b + (m0 >> 32);
+            hi = hi * 0x13b + (m1 >> 32) + (lo << 24);
+            lo = (m1 << 32) | (m0 & 0xffffffffULL);
+        }
+        hi_ = hi;
+        lo_ = lo;
+        return *this;
+    }
+
+    fnv1a128& add(char const* s) { return add(s, std::strlen(s) + 1); }
+    fnv1a128& add(std::string const& s) { return add(s.c_str(), s.size() + 1); }
+
+    fnv1a128& add_u64(u64 v) {
+        unsigned char b[8];
+        for (int i = 0; i < 8; ++i)
+            b[i] = (unsigned char)(v >> (i * 8));
+        return add(b, 8);
+    }
+
+    std::string hex() const { return fnv1a64::to_hex(hi_) + fnv1a64::to_hex(lo_); }
+
+private:
+    u64     hi_;
+    u64     lo_;
+};
+
+/// SHA-256 (FIPS 180-4).
+class sha256 {
+public:
+    typedef unsigned int u32;
+
+    sha256() : size_(0), used_(0) {
+        static u32 const init[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+        };
+        std::memcpy(h_, init, sizeof h_);
+    }
+
+    sha256& add(void const* data, std::size_t size) {
+        unsigned char const* p = (unsigned char const*)data;
+        size_ += size;
+        while (size > 0) {
+            std::size_t n = 64 - used_;
+            if (n > size)
+                n = size;
+            std::memcpy(buf_ + used_, p, n);
+            used_ += n;
+            p     += n;
+            size  -= n;
+            if (used_ == 64) {
+                block(buf_);
+                used_ = 0;
+            }
+        }
+        return *this;
+    }
+
+    sha256& add(std::string const& s) { return add(s.data(), s.size()); }
+
+    /// The 32 bytes of the digest. (this is left finished)
+    std::string digest() {
+        unsigned long long bits = size_ * 8;
+        unsigned char      pad  = 0x80;
+        add(&pad, 1);
+        pad = 0;
+        while (used_ != 56)
+            add(&pad, 1);
+        unsigned char len[8];
+        for (int i = 0; i < 8; ++i)
+            len[i] = (unsigned char)(bits >> (56 - i * 8));
+        add(len, 8);
+        std::string d(32, '\0');
+        for (int i = 0; i < 32; ++i)
+            d[i] = char(h_[i / 4] >> (24 - (i % 4) * 8));
+        return d;
+    }
+
+private:
+    static u32 rotr(u32 x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void block(unsigned char const* b) {
+        static u32 const k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+        };
+        u32 w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = u32(b[i * 4]) << 24 | u32(b[i * 4 + 1]) << 16 | u32(b[i * 4 + 2]) << 8 | u32(b[i * 4 + 3]);
+        for (int i = 16; i < 64; ++i) {
+            u32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            u32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        u32 a = h_[0], b1 = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+        for (int i = 0; i < 64; ++i) {
+            u32 t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            u32 t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b1) ^ (a & c) ^ (b1 & c));
+            h  = g;
+            g  = f;
+            f  = e;
+            e  = d + t1;
+            d  = c;
+            c  = b1;
+            b1 = a;
+            a  = t1 + t2;
+        }
+        h_[0] += a; h_[1] += b1; h_[2] += c; h_[3] += d;
+        h_[4] += e; h_[5] += f;  h_[6] += g; h_[7] += h;
+    }
+
+private:
+    u32                 h_[8];
+    unsigned char       buf_[64];
+    unsigned long long  size_;
+    std::size_t         used_;
+};
+
+/// HMAC-SHA-256 of msg by key, as hex.
+inline std::string hmac_sha256_hex(std::string key, std::string const& msg) {
+    if (key.size() > 64)
+        key = sha256().add(key).digest();
+    key.resize(64, '\0');
+    std::string ipad(key), opad(key);
+    for (std::size_t i = 0; i < 64; ++i) {
+        ipad[i] = char(ipad[i] ^ 0x36);
+        opad[i] = char(opad[i] ^ 0x5c);
+    }
+    std::string d = sha256().add(opad).add(sha256().add(ipad).add(msg).digest()).digest();
+    static char const digits[] = "0123456789abcdef";
+    std::string hex;
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        hex += digits[(unsigned char)d[i] >> 4];
+        hex += digits[(unsigned char)d[i] & 15];
+    }
+    return hex;
+}
+
+/// a == b, in a time not depending on where they differ.
+inline bool equal_const_time(std::string const& a, std::string const& b) {
+    if (a.size() != b.size())
+        return false;
+    unsigned char d = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        d |= (unsigned char)(a[i] ^ b[i]);
+    return d == 0;
+}
+
+}   // hash_util
+}   // zatu
+
+#endif  // ZATU_HASH_UTIL_HPP_INCLUDED
@@ -0,0 +1,248 @@
+/**
+ *  @file   jobserver_util.hpp
+ *  @brief  Client of the GNU make jobserver.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    MAKEFLAGS: --jobserver-auth=R,W (or --jobserver-fds=R,W)  pipe fds.
+ *               --jobserver-auth=fifo:PATH                     make 4.4
+ *               --jobserver-auth=NAME                          Windows semaphore.
+ *    A process started by make owns one implicit token. Each extra child
+ *    needs acquire() before and release() after. The held tokens are also
+ *    given back on exit or on SIGINT/SIGTERM/SIGHUP (Ctrl-C on Windows).
+ *    The pipe fds are read through a non-blocking descriptor of their own
+ *    (/proc/self/fd), so make's blocking mode of the pipe is not changed.
+ *
+ *  ex)
+ *    jobserver_util::client js;
+ *    js.open(getenv("MAKEFLAGS"));
+ *    if (running == 0 || js.acquire(0))
+ *        start_child();
+ */
+#ifndef ZATU_JOBSERVER_UTIL_HPP_INCLUDED
+#define ZATU_JOBSERVER_UTIL_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <cerrno>
+#endif
+
+namespace zatu {
+namespace jobserver_util {
+
+namespace _detail {
+    /// The tokens held by this process. One per process, for the signal handler.
+    struct state_t {
+     #if defined(_WIN32)
+        HANDLE          sem;
+        volatile LONG   held;
+     #else
+        int             rfd;
+        int             wfd;
+        volatile sig_atomic_t held;
+        char            bytes[256];     // the tokens read, written back as they were.
+     #endif
+        bool            hooked;
+    };
+
+    inline state_t& state() {
+     #if defined(_WIN32)
+        static state_t st = { NULL, 0, false };
+     #else
+        static state_t st = { -1, -1, 0, {0}, false };
+     #endif
+        return st;
+    }
+
+ #if defined(_WIN32)
+    inline void release_all() {
+        state_t& st = state();
+        LONG     n  = InterlockedExchange(&st.held, 0);
+        if (n > 0 && st.sem)
+            ReleaseSemaphore(st.sem, n, NULL);
+    }
+
+    inline BOOL WINAPI on_ctrl(DWORD) {
+        release_all();
+        return FALSE;
+    }
+ #else
+    inline void release_all() {
+        state_t& st = state();
+        int      n  = st.held;
+        st.held = 0;
+        if (n > 0 && st.wfd >= 0) {
+            ssize_t r;
+            do {
+                r = ::write(st.wfd, st.bytes, std::size_t(n));
+            } while (r < 0 && errno == EINTR);
+        }
+    }
+
+    inline void on_signal(int sig) {
+        release_all();
+        ::signal(sig, SIG_DFL);
+        ::raise(sig);
+    }
+ #endif
+
+    inline void exit_hook() { release_all(); }
+
+    inline void hook() {
+        state_t& st = state();
+        if (st.hooked)
+            return;
+        st.hooked = true;
+        std::atexit(exit_hook);
+     #if defined(_WIN32)
+        SetConsoleCtrlHandler(on_ctrl, TRUE);
+     #else
+        static int const sigs[] = { SIGINT, SIGTERM, SIGHUP };
+        for (std::size_t i = 0; i < sizeof sigs / sizeof sigs[0]; ++i) {
+            if (::signal(sigs[i], on_signal) == SIG_IGN)
+                ::signal(sigs[i], SIG_IGN);
+        }
+     #endif
+    }
+
+    /// Value of the last --jobserver-auth= (or --jobserver-fds=) in makeflags.
+    inline std::string auth_value(char const* makeflags) {
+        std::string v;
+        if (makeflags == NULL)
+            return v;
+        static char const* const keys[] = { "--jobserver-auth=", "--jobserver-fds=" };
+        for (std::size_t k = 0; k < 2 && v.empty(); ++k) {
+            for (char const* p = std::strstr(makeflags, keys[k]); p; p = std::strstr(p + 1, keys[k])) {
+                p += std::strlen(keys[k]);
+                std::size_t n = std::strcspn(p, " \t");
+                v.assign(p, n);
+            }
+        }
+        return v;
+    }
+}
+
+class client {
+public:
+    client() {}
+    ~client() { _detail::release_all(); }
+
+    /// Connect to the jobserver of makeflags. @return false if there is none (no limit then).
+    bool open(char const* makeflags) {
+        _detail::state_t& st   = _detail::state();
+        std::string       auth = _detail::auth_value(makeflags);
+        if (auth.empty() || enabled())
+            return enabled();
+     #if defined(_WIN32)
+        if (auth.compare(0, 5, "fifo:") == 0 || auth.find(',') != std::string::npos)
+            return false;
+        st.sem = OpenSemaphoreA(SEMAPHORE_MODIFY_STATE | SYNCHRONIZE, FALSE, auth.c_str());
+     #else
+        if (auth.compare(0, 5, "fifo:") == 0) {
+            int fd = ::open(auth.c_str() + 5, O_RDWR | O_NONBLOCK);
+            if (fd < 0)
+                return false;
+            st.rfd = fd;
+            st.wfd = fd;
+        } else {
+            int r = -1, w = -1;
+            if (std::sscanf(auth.c_str(), "%d,%d", &r, &w) != 2 || r < 0 || w < 0
+                || ::fcntl(r, F_GETFD) < 0 || ::fcntl(w, F_GETFD) < 0)
+            {
+                return false;   // make did not pass the fds to this process. ('+' missing)
+            }
+            char path[64];
+            std::sprintf(path, "/proc/self/fd/%d", r);
+            int fd = ::open(path, O_RDONLY | O_NONBLOCK);
+            if (fd < 0)
+                return false;
+            st.rfd = fd;
+            st.wfd = w;
+        }
+     #endif
+        if (enabled())
+            _detail::hook();
+        return enabled();
+    }
+
+    bool enabled() const {
+     #if defined(_WIN32)
+        return _detail::state().sem != NULL;
+     #else
+        return _detail::state().rfd >= 0;
+     #endif
+    }
+
+    unsigned held() const { return unsigned(_detail::state().held); }
+
+    /// Take a token, waiting at most wait_ms milliseconds.
+    bool acquire(unsigned wait_ms) {
+        _detail::state_t& st = _detail::state();
+     #if defined(_WIN32)
+        if (st.sem == NULL || WaitForSingleObject(st.sem, wait_ms) != WAIT_OBJECT_0)
+            return false;
+        InterlockedIncrement(&st.held);
+        return true;
+     #else
+        if (st.rfd < 0 || st.held >= int(sizeof st.bytes))
+            return false;
+        pollfd pf;
+        pf.fd      = st.rfd;
+        pf.events  = POLLIN;
+        pf.revents = 0;
+        if (::poll(&pf, 1, int(wait_ms)) <= 0)
+            return false;
+        char c;
+        if (::read(st.rfd, &c, 1) != 1)
+            return false;       // taken by another process first.
+        st.bytes[st.held] = c;
+        st.held = st.held + 1;
+        return true;
+     #endif
+    }
+
+    /// Give back tokens until n are held.
+    void release_to(unsigned n) {
+        _detail::state_t& st = _detail::state();
+     #if defined(_WIN32)
+        while (unsigned(st.held) > n) {
+            InterlockedDecrement(&st.held);
+            ReleaseSemaphore(st.sem, 1, NULL);
+        }
+     #else
+        while (unsigned(st.held) > n) {
+            char    c = st.bytes[st.held - 1];
+            ssize_t r = ::write(st.wfd, &c, 1);
+            if (r < 0 && errno == EINTR)
+                continue;
+            st.held = st.held - 1;
+        }
+     #endif
+    }
+
+private:
+    client(client const&);
+    client& operator=(client const&);
+};
+
+}   // jobserver_util
+}   // zatu
+
+#endif  // ZATU_JOBSERVER_UTIL_HPP_INCLUDED
@@ -0,0 +1,387 @@
+/**
+ *  @file   net_util.hpp
+ *  @brief  Minimal TCP socket helpers and string-list messages.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    A message is: u32 count, then count * (u32 length, bytes). (little endian)
+ *    A received message is at most max_bytes in all. (64 MB by default)
+ *    A server reading many clients at once: wait_readable_any, recv_some, parse_strs.
+ *
+ *  ex)
+ *    net_util::socket_t s = net_util::tcp_connect("127.0.0.1", 4717);
+ *    if (net_util::sock_valid(s) && net_util::send_strs(s, req))
+ *        net_util::recv_strs(s, res);
+ *    net_util::sock_close(s);
+ */
+#ifndef ZATU_NET_UTIL_HPP_INCLUDED
+#define ZATU_NET_UTIL_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <wincrypt.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "advapi32.lib")
+#endif
+#else
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#endif
+
+namespace zatu {
+namespace net_util {
+
+#if defined(_WIN32)
+typedef SOCKET  socket_t;
+inline bool sock_valid(socket_t s) { return s != INVALID_SOCKET; }
+inline socket_t invalid_socket() { return INVALID_SOCKET; }
+#else
+typedef int     socket_t;
+inline bool sock_valid(socket_t s) { return s >= 0; }
+inline socket_t invalid_socket() { return -1; }
+#endif
+
+inline bool net_init() {
+ #if defined(_WIN32)
+    static bool done = false;
+    if (!done) {
+        WSADATA wd;
+        if (WSAStartup(MAKEWORD(2, 2), &wd) != 0)
+            return false;
+        done = true;
+    }
+ #endif
+    return true;
+}
+
+inline void sock_close(socket_t s) {
+    if (!sock_valid(s))
+        return;
+ #if defined(_WIN32)
+    closesocket(s);
+ #else
+    ::close(s);
+ #endif
+}
+
+/// "host:port" or "port". host is "127.0.0.1" if omitted.
+inline bool parse_host_port(char const* s, std::string& host, unsigned short& port) {
+    if (s == NULL || *s == 0)
+        return false;
+    char const* c = std::strrchr(s, ':');
+    char const* p = s;
+    host = "127.0.0.1";
+    if (c) {
+        if (c > s)
+            host.assign(s, c);
+        p = c + 1;
+    }
+    char* e = NULL;
+    unsigned long n = std::strtoul(p, &e, 10);
+    if (e == p || *e || n == 0 || n > 0xFFFF)
+        return false;
+    port = (unsigned short)n;
+    return true;
+}
+
+inline bool make_addr(char const* host, unsigned short port, sockaddr_in& sa) {
+    std::memset(&sa, 0, sizeof sa);
+    sa.sin_family = AF_INET;
+    sa.sin_port   = htons(port);
+    unsigned long a = inet_addr(host);
+    if (a == (unsigned long)INADDR_NONE) {
+        hostent* he = gethostbyname(host);
+        if (he == NULL || he->h_addrtype != AF_INET)
+            return false;
+        std::memcpy(&sa.sin_addr, he->h_addr_list[0], sizeof sa.sin_addr);
+    } else {
+        sa.sin_addr.s_addr = a;
+    }
+    return true;
+}
+
+/// true if host is (or resolves to) 127.x.x.x.
+inline bool is_loopback(char const* host) {
+    sockaddr_in sa;
+    if (!net_init() || !make_addr(host, 0, sa))
+        return false;
+    return (ntohl(sa.sin_addr.s_addr) >> 24) == 127;
+}
+
+inline socket_t tcp_listen(char const* host, unsigned short port, int backlog = 64) {
+    sockaddr_in sa;
+    if (!net_init() || !make_addr(host, port, sa))
+        return invalid_socket();
+    socket_t s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (!sock_valid(s))
+        return s;
+    int on = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char const*)&on, sizeof on);
+    if (::bind(s, (sockaddr*)&sa, sizeof sa) != 0 || ::listen(s, backlog) != 0) {
+        sock_close(s);
+        return invalid_socket();
+    }
+    return s;
+}
+
+inline socket_t tcp_accept(socket_t ls) {
+    socket_t s = ::accept(ls, NULL, NULL);
+    if (sock_valid(s)) {
+        int on = 1;
+        ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char const*)&on, sizeof on);
+    }
+    return s;
+}
+
+inline socket_t tcp_connect(char const* host, unsigned short port) {
+    sockaddr_in sa;
+    if (!net_init() || !make_addr(host, port, sa))
+        return invalid_socket();
+    socket_t s = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (!sock_valid(s))
+        return s;
+    if (::connect(s, (sockaddr*)&sa, sizeof sa) != 0) {
+        sock_close(s);
+        return invalid_socket();
+    }
+    int on = 1;
+    ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char const*)&on, sizeof on);
+    return s;
+}
+
+/// Make send/recv on s fail after ms milliseconds without progress.
+inline bool sock_set_timeout(socket_t s, unsigned ms) {
+ #if defined(_WIN32)
+    DWORD  tv = ms;
+ #else
+    timeval tv;
+    tv.tv_sec  = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+ #endif
+    return ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (char const*)&tv, sizeof tv) == 0
+        && ::setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (char const*)&tv, sizeof tv) == 0;
+}
+
+/// Wait until s is readable (or a listening s has a connection), at most ms milliseconds.
+inline bool wait_readable(socket_t s, unsigned ms) {
+    fd_set rs;
+    FD_ZERO(&rs);
+    FD_SET(s, &rs);
+    timeval tv;
+    tv.tv_sec  = long(ms / 1000);
+    tv.tv_usec = long(ms % 1000) * 1000;
+    return ::select(int(s + 1), &rs, NULL, NULL, &tv) > 0;
+}
+
+/** Wait until any of socks[0..n) is readable, at most ms milliseconds.
+ *  ready[i] is set to 1 for each readable one. @return number of them. (-1: error)
+ *  n must be less than FD_SETSIZE. (64 on Windows)
+ */
+inline int wait_readable_any(socket_t const* socks, std::size_t n, unsigned ms, std::vector<char>& ready) {
+    fd_set   rs;
+    socket_t top = 0;
+    FD_ZERO(&rs);
+    for (std::size_t i = 0; i < n; ++i) {
+        FD_SET(socks[i], &rs);
+        if (socks[i] > top)
+            top = socks[i];
+    }
+    timeval tv;
+    tv.tv_sec  = long(ms / 1000);
+    tv.tv_usec = long(ms % 1000) * 1000;
+    int r = ::select(int(top + 1), &rs, NULL, NULL, &tv);
+    ready.assign(n, 0);
+    for (std::size_t i = 0; r > 0 && i < n; ++i)
+        ready[i] = FD_ISSET(socks[i], &rs) ? 1 : 0;
+    return r;
+}
+
+inline bool send_all(socket_t s, void const* data, std::size_t size) {
+    char const* p = (char const*)data;
+    while (size > 0) {
+     #if defined(_WIN32)
+        int n = ::send(s, p, int(size), 0);
+     #elif defined(MSG_NOSIGNAL)
+        ssize_t n = ::send(s, p, size, MSG_NOSIGNAL);
+     #else
+        ssize_t n = ::send(s, p, size, 0);
+     #endif
+        if (n <= 0)
+            return false;
+        p    += n;
+        size -= std::size_t(n);
+    }
+    return true;
+}
+
+inline bool recv_all(socket_t s, void* data, std::size_t size) {
+    char* p = (char*)data;
+    while (size > 0) {
+     #if defined(_WIN32)
+        int n = ::recv(s, p, int(size), 0);
+     #else
+        ssize_t n = ::recv(s, p, size, 0);
+     #endif
+        if (n <= 0)
+            return false;
+        p    += n;
+        size -= std::size_t(n);
+    }
+    return true;
+}
+
+namespace _detail {
+    inline void put_u32(std::string& b, std::size_t v) {
+        for (int i = 0; i < 4; ++i)
+            b += char((v >> (i * 8)) & 0xFF);
+    }
+    inline std::size_t get_u32(unsigned char const* p) {
+        return std::size_t(p[0]) | std::size_t(p[1]) << 8 | std::size_t(p[2]) << 16 | std::size_t(p[3]) << 24;
+    }
+}
+
+inline bool send_strs(socket_t s, std::vector<std::string> const& v) {
+    std::string b;
+    std::size_t total = 4;
+    for (std::size_t i = 0; i < v.size(); ++i)
+        total += 4 + v[i].size();
+    b.reserve(total);
+    _detail::put_u32(b, v.size());
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        _detail::put_u32(b, v[i].size());
+        b += v[i];
+    }
+    return send_all(s, b.data(), b.size());
+}
+
+inline bool recv_strs(socket_t s, std::vector<std::string>& v, std::size_t max_bytes = 0x4000000) {
+    unsigned char h[4];
+    v.clear();
+    if (!recv_all(s, h, 4))
+        return false;
+    std::size_t n    = _detail::get_u32(h);
+    std::size_t left = max_bytes;
+    if (n > left / 4)
+        return false;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!recv_all(s, h, 4))
+            return false;
+        std::size_t len = _detail::get_u32(h);
+        if (len + 4 > left)
+            return false;
+        left -= len + 4;
+        v.push_back(std::string());
+        v.back().resize(len);
+        if (len && !recv_all(s, &v.back()[0], len))
+            return false;
+    }
+    return true;
+}
+
+/// Append what is available on s to buf (s should be readable). @return bytes read (0: closed, -1: error)
+inline long recv_some(socket_t s, std::string& buf) {
+    char b[0x4000];
+ #if defined(_WIN32)
+    int n = ::recv(s, b, int(sizeof b), 0);
+ #else
+    ssize_t n = ::recv(s, b, sizeof b, 0);
+ #endif
+    if (n > 0)
+        buf.append(b, std::size_t(n));
+    return (n < 0) ? -1L : long(n);
+}
+
+/** Take the message at the head of buf (bytes of recv_some) into v.
+ *  @return 1: done, and the message is erased from buf  0: not all received yet
+ *         -1: the message is over max_bytes.
+ */
+inline int parse_strs(std::string& buf, std::vector<std::string>& v, std::size_t max_bytes = 0x4000000) {
+    unsigned char const* p = (unsigned char const*)buf.data();
+    std::size_t          size = buf.size();
+    if (size < 4)
+        return 0;
+    std::size_t n   = _detail::get_u32(p);
+    std::size_t pos = 4;
+    if (n > max_bytes / 4)
+        return -1;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (size - pos < 4)
+            return 0;
+        std::size_t len = _detail::get_u32(p + pos);
+        if (len + pos + 4 > max_bytes)
+            return -1;
+        pos += 4;
+        if (size - pos < len)
+            return 0;
+        pos += len;
+    }
+    v.clear();
+    v.reserve(n);
+    pos = 4;
+    for (std::size_t i = 0; i < n; ++i) {
+        std::size_t len = _detail::get_u32(p + pos);
+        v.push_back(buf.substr(pos + 4, len));
+        pos += 4 + len;
+    }
+    buf.erase(0, pos);
+    return 1;
+}
+
+/// bytes random bytes of the OS, as hex. (for shared secrets)
+inline bool random_hex(std::size_t bytes, std::string& hex) {
+    std::vector<unsigned char> b(bytes);
+ #if defined(_WIN32)
+    HCRYPTPROV prov = 0;
+    if (!CryptAcquireContextA(&prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT | CRYPT_SILENT))
+        return false;
+    bool ok = CryptGenRandom(prov, DWORD(bytes), &b[0]) != 0;
+    CryptReleaseContext(prov, 0);
+    if (!ok)
+        return false;
+ #else
+    int fd = ::open("/dev/urandom", O_RDONLY);
+    if (fd < 0)
+        return false;
+    std::size_t got = 0;
+    while (got < bytes) {
+        ssize_t n = ::read(fd, &b[got], bytes - got);
+        if (n <= 0)
+            break;
+        got += std::size_t(n);
+    }
+    ::close(fd);
+    if (got < bytes)
+        return false;
+ #endif
+    static char const digits[] = "0123456789abcdef";
+    hex.clear();
+    for (std::size_t i = 0; i < bytes; ++i) {
+        hex += digits[b[i] >> 4];
+        hex += digits[b[i] & 15];
+    }
+    return true;
+}
+
+}   // net_util
+}   // zatu
+
+#endif  // ZATU_NET_UTIL_HPP_INCLUDED
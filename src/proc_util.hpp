@@ -0,0 +1,505 @@
+/**
+ *  @file   proc_util.hpp
+ *  @brief  Start and wait child processes.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *
+ *  ex)
+ *    proc_util::proc_t p;
+ *    if (proc_util::proc_start(argv, "out.txt", p))
+ *        rc = proc_util::proc_wait(p);
+ *    Resource usage of the child is taken by proc_wait(p, &usage).
+ *    (Windows: GetProcessTimes and psapi GetProcessMemoryInfo, others: wait4)
+ *    proc_start_pipe() gives the output of the child as it is written.
+ *    env_list() and env_set() read and change the environment the children get.
+ */
+#ifndef ZATU_PROC_UTIL_HPP_INCLUDED
+#define ZATU_PROC_UTIL_HPP_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+extern char** environ;
+#endif
+
+namespace zatu {
+namespace proc_util {
+
+/// Child process handle.
+struct proc_t {
+ #if defined(_WIN32)
+    HANDLE  handle;
+    proc_t() : handle(NULL) {}
+    bool running() const { return handle != NULL; }
+ #else
+    pid_t   pid;
+    proc_t() : pid(0) {}
+    bool running() const { return pid > 0; }
+ #endif
+};
+
+/// Resource usage of a finished child.
+struct proc_usage_t {
+    double              user_sec;
+    double              sys_sec;
+    unsigned long long  peak_rss;   // bytes.
+    proc_usage_t() : user_sec(0), sys_sec(0), peak_rss(0) {}
+};
+
+namespace _detail {
+ #if defined(_WIN32)
+    inline double filetime_sec(FILETIME const& ft) {
+        return double((unsigned long long)ft.dwHighDateTime << 32 | ft.dwLowDateTime) * 1e-7;
+    }
+
+    /// PROCESS_MEMORY_COUNTERS of psapi.h. (not in every SDK)
+    struct pmc_t {
+        DWORD   cb;
+        DWORD   PageFaultCount;
+        SIZE_T  PeakWorkingSetSize;
+        SIZE_T  WorkingSetSize;
+        SIZE_T  QuotaPeakPagedPoolUsage;
+        SIZE_T  QuotaPagedPoolUsage;
+        SIZE_T  QuotaPeakNonPagedPoolUsage;
+        SIZE_T  QuotaNonPagedPoolUsage;
+        SIZE_T  PagefileUsage;
+        SIZE_T  PeakPagefileUsage;
+    };
+
+    inline void get_usage(HANDLE h, proc_usage_t& u) {
+        FILETIME c, e, k, us;
+        if (GetProcessTimes(h, &c, &e, &k, &us)) {
+            u.user_sec = filetime_sec(us);
+            u.sys_sec  = filetime_sec(k);
+        }
+        typedef BOOL (WINAPI *gpmi_t)(HANDLE, pmc_t*, DWORD);
+        static gpmi_t gpmi   = NULL;
+        static bool   loaded = false;
+        if (!loaded) {
+            loaded = true;
+            HMODULE m = LoadLibraryA("psapi.dll");
+            if (m)
+                gpmi = (gpmi_t)GetProcAddress(m, "GetProcessMemoryInfo");
+        }
+        pmc_t pmc;
+        memset(&pmc, 0, sizeof pmc);
+        pmc.cb = sizeof pmc;
+        if (gpmi && gpmi(h, &pmc, sizeof pmc))
+            u.peak_rss = pmc.PeakWorkingSetSize;
+    }
+ #else
+    inline void get_usage(rusage const& ru, proc_usage_t& u) {
+        u.user_sec = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6;
+        u.sys_sec  = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+      #if defined(__APPLE__)
+        u.peak_rss = (unsigned long long)ru.ru_maxrss;
+      #else
+        u.peak_rss = (unsigned long long)ru.ru_maxrss * 1024;
+      #endif
+    }
+ #endif
+}
+
+/// Number of logical processors.
+inline unsigned cpu_count() {
+ #if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? unsigned(si.dwNumberOfProcessors) : 1;
+ #else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? unsigned(n) : 1;
+ #endif
+}
+
+inline unsigned get_pid() {
+ #if defined(_WIN32)
+    return unsigned(GetCurrentProcessId());
+ #else
+    return unsigned(getpid());
+ #endif
+}
+
+/// Path of the running executable. (argv0 if unknown)
+inline std::string self_path(char const* argv0) {
+    char buf[4096] = {0};
+ #if defined(_WIN32)
+    DWORD n = GetModuleFileNameA(NULL, buf, sizeof buf);
+    if (n > 0 && n < sizeof buf)
+        return std::string(buf, n);
+ #else
+    ssize_t n = ::readlink("/proc/self/exe", buf, sizeof buf - 1);
+    if (n > 0)
+        return std::string(buf, n);
+ #endif
+    return argv0;
+}
+
+/// Temporary directory with trailing separator.
+inline std::string temp_dir() {
+    std::string dir;
+ #if defined(_WIN32)
+    char buf[MAX_PATH + 1] = {0};
+    DWORD n = GetTempPathA(MAX_PATH, buf);
+    dir.assign(buf, (n > 0 && n <= MAX_PATH) ? n : 0);
+    if (dir.empty())
+        dir = ".\\";
+    else if (dir[dir.size()-1] != '\\' && dir[dir.size()-1] != '/')
+        dir += '\\';
+ #else
+    char const* t = getenv("TMPDIR");
+    dir = (t && *t) ? t : "/tmp";
+    if (dir[dir.size()-1] != '/')
+        dir += '/';
+ #endif
+    return dir;
+}
+
+/// The environment of this process, as "NAME=VALUE".
+inline void env_list(std::vector<std::string>& v) {
+    v.clear();
+ #if defined(_WIN32)
+    char* env = GetEnvironmentStringsA();
+    for (char const* p = env; p && *p; p += std::strlen(p) + 1) {
+        if (*p != '=')      // "=C:=C:\dir" of cmd.exe.
+            v.push_back(p);
+    }
+    if (env)
+        FreeEnvironmentStringsA(env);
+ #else
+    for (char** p = environ; p && *p; ++p)
+        v.push_back(*p);
+ #endif
+}
+
+/// Set the environment variable name to value, or remove it if value is NULL.
+inline void env_set(std::string const& name, char const* value) {
+ #if defined(_WIN32)
+    SetEnvironmentVariableA(name.c_str(), value);
+    std::string s = name + "=" + (value ? value : "");     // "NAME=" removes.
+  #if defined(_MSC_VER)
+    _putenv(s.c_str());
+  #else
+    putenv(strdup(s.c_str()));      // may keep the pointer.
+  #endif
+ #else
+    if (value)
+        setenv(name.c_str(), value, 1);
+    else
+        unsetenv(name.c_str());
+ #endif
+}
+
+/// Append one argument to a command line, quoted for CommandLineToArgv rules.
+inline void append_quoted_arg(std::string& cmdline, char const* a) {
+    if (*a && !strpbrk(a, " \t\n\v\"")) {
+        cmdline += a;
+        return;
+    }
+    cmdline += '"';
+    for (;;) {
+        std::size_t bsl = 0;
+        while (*a == '\\') {
+            ++a;
+            ++bsl;
+        }
+        if (*a == '\0') {
+            cmdline.append(bsl * 2, '\\');
+            break;
+        } else if (*a == '"') {
+            cmdline.append(bsl * 2 + 1, '\\');
+            cmdline += '"';
+        } else {
+            cmdline.append(bsl, '\\');
+            cmdline += *a;
+        }
+        ++a;
+    }
+    cmdline += '"';
+}
+
+/// Read end of the stdout/stderr pipe of a child. (proc_start_pipe)
+struct pipe_t {
+ #if defined(_WIN32)
+    HANDLE  handle;
+    pipe_t() : handle(NULL) {}
+ #else
+    int     fd;
+    pipe_t() : fd(-1) {}
+ #endif
+};
+
+namespace _detail {
+ #if defined(_WIN32)
+    /// Start argv with stdout and stderr to out (inheritable, or INVALID_HANDLE_VALUE). out is closed.
+    inline bool spawn(char const* const* argv, HANDLE out, proc_t& p) {
+        std::string cmdline;
+        for (std::size_t i = 0; argv[i]; ++i) {
+            if (i)
+                cmdline += ' ';
+            append_quoted_arg(cmdline, argv[i]);
+        }
+        STARTUPINFOA si;
+        memset(&si, 0, sizeof si);
+        si.cb = sizeof si;
+        if (out != INVALID_HANDLE_VALUE) {
+            si.dwFlags    = STARTF_USESTDHANDLES;
+            si.hStdInput  = GetStdHandle(STD_INPUT_HANDLE);
+            si.hStdOutput = out;
+            si.hStdError  = out;
+        }
+        PROCESS_INFORMATION pi;
+        BOOL ok = CreateProcessA(argv[0], &cmdline[0], NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi);
+        if (out != INVALID_HANDLE_VALUE)
+            CloseHandle(out);
+        if (!ok)
+            return false;
+        CloseHandle(pi.hThread);
+        p.handle = pi.hProcess;
+        return true;
+    }
+ #else
+    /// Start argv with stdout and stderr to fd (or -1). fd and close_fd are closed in the parent.
+    inline bool spawn(char const* const* argv, int fd, int close_fd, proc_t& p) {
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (close_fd != -1)
+                close(close_fd);
+            if (fd != -1) {
+                dup2(fd, 1);
+                dup2(fd, 2);
+                close(fd);
+            }
+            execv(argv[0], (char* const*)argv);
+            _exit(127);
+        }
+        if (fd != -1)
+            close(fd);
+        if (pid < 0)
+            return false;
+        p.pid = pid;
+        return true;
+    }
+ #endif
+}
+
+/** Start argv[0] with argv (NULL terminated).
+ *  If out_path is not NULL, stdout and stderr of the child are written to out_path.
+ */
+inline bool proc_start(char const* const* argv, char const* out_path, proc_t& p) {
+ #if defined(_WIN32)
+    HANDLE h = INVALID_HANDLE_VALUE;
+    if (out_path) {
+        SECURITY_ATTRIBUTES sa;
+        sa.nLength              = sizeof sa;
+        sa.lpSecurityDescriptor = NULL;
+        sa.bInheritHandle       = TRUE;
+        h = CreateFileA(out_path, GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, &sa
+                        , CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+        if (h == INVALID_HANDLE_VALUE)
+            return false;
+    }
+    return _detail::spawn(argv, h, p);
+ #else
+    int fd = -1;
+    if (out_path) {
+        fd = ::open(out_path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if (fd == -1)
+            return false;
+    }
+    return _detail::spawn(argv, fd, -1, p);
+ #endif
+}
+
+/// Start argv with stdout and stderr to a pipe. Read it by pipe_read() until 0, then pipe_close().
+inline bool proc_start_pipe(char const* const* argv, proc_t& p, pipe_t& rd) {
+ #if defined(_WIN32)
+    SECURITY_ATTRIBUTES sa;
+    sa.nLength              = sizeof sa;
+    sa.lpSecurityDescriptor = NULL;
+    sa.bInheritHandle       = TRUE;
+    HANDLE r = NULL, w = NULL;
+    if (!CreatePipe(&r, &w, &sa, 0))
+        return false;
+    SetHandleInformation(r, HANDLE_FLAG_INHERIT, 0);
+    if (!_detail::spawn(argv, w, p)) {
+        CloseHandle(r);
+        return false;
+    }
+    rd.handle = r;
+    return true;
+ #else
+    int fds[2];
+    if (::pipe(fds) != 0)
+        return false;
+    if (!_detail::spawn(argv, fds[1], fds[0], p)) {
+        close(fds[0]);
+        return false;
+    }
+    rd.fd = fds[0];
+    return true;
+ #endif
+}
+
+/// Read what is available, blocking until some. @return bytes read (0: end, -1: error)
+inline long pipe_read(pipe_t& rd, char* buf, std::size_t size) {
+ #if defined(_WIN32)
+    DWORD n = 0;
+    if (!ReadFile(rd.handle, buf, DWORD(size), &n, NULL))
+        return (GetLastError() == ERROR_BROKEN_PIPE) ? 0 : -1;
+    return long(n);
+ #else
+    for (;;) {
+        ssize_t n = ::read(rd.fd, buf, size);
+        if (n >= 0 || errno != EINTR)
+            return long(n);
+    }
+ #endif
+}
+
+inline void pipe_close(pipe_t& rd) {
+ #if defined(_WIN32)
+    if (rd.handle)
+        CloseHandle(rd.handle);
+    rd.handle = NULL;
+ #else
+    if (rd.fd != -1)
+        close(rd.fd);
+    rd.fd = -1;
+ #endif
+}
+
+/// Wait for p and return its exit code. (-1: error)  usage: if not NULL, receives the resource usage.
+inline int proc_wait(proc_t& p, proc_usage_t* usage = NULL) {
+    int rc = -1;
+ #if defined(_WIN32)
+    if (p.handle == NULL)
+        return -1;
+    DWORD code = DWORD(-1);
+    if (WaitForSingleObject(p.handle, INFINITE) == WAIT_OBJECT_0)
+        GetExitCodeProcess(p.handle, &code);
+    if (usage)
+        _detail::get_usage(p.handle, *usage);
+    CloseHandle(p.handle);
+    p.handle = NULL;
+    rc = int(code);
+ #else
+    if (p.pid <= 0)
+        return -1;
+    int    st = 0;
+    rusage ru;
+    while (wait4(p.pid, &st, 0, &ru) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    if (usage)
+        _detail::get_usage(ru, *usage);
+    p.pid = 0;
+    rc = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+ #endif
+    return rc;
+}
+
+/// If p has finished, reap it and set rc. @return false while p is running.
+inline bool proc_try_wait(proc_t& p, int& rc, proc_usage_t* usage = NULL) {
+ #if defined(_WIN32)
+    if (p.handle && WaitForSingleObject(p.handle, 0) == WAIT_TIMEOUT)
+        return false;
+    rc = proc_wait(p, usage);
+    return true;
+ #else
+    if (p.pid <= 0) {
+        rc = -1;
+        return true;
+    }
+    int    st = 0;
+    rusage ru;
+    pid_t  r  = wait4(p.pid, &st, WNOHANG, &ru);
+    if (r == 0 || (r < 0 && errno == EINTR))
+        return false;
+    if (r > 0 && usage)
+        _detail::get_usage(ru, *usage);
+    p.pid = 0;
+    rc = (r > 0 && WIFEXITED(st)) ? WEXITSTATUS(st) : -1;
+    return true;
+ #endif
+}
+
+/** Wait for any of ps[0..n) to finish.
+ *  @return index of the finished process (-1: error). The exit code is stored in rc.
+ */
+inline int proc_wait_any(proc_t* ps, std::size_t n, int& rc, proc_usage_t* usage = NULL) {
+ #if defined(_WIN32)
+    HANDLE      hs[MAXIMUM_WAIT_OBJECTS];
+    std::size_t idx[MAXIMUM_WAIT_OBJECTS];
+    DWORD       m = 0;
+    for (std::size_t i = 0; i < n && m < MAXIMUM_WAIT_OBJECTS; ++i) {
+        if (ps[i].handle) {
+            hs[m]  = ps[i].handle;
+            idx[m] = i;
+            ++m;
+        }
+    }
+    if (m == 0)
+        return -1;
+    DWORD w = WaitForMultipleObjects(m, hs, FALSE, INFINITE);
+    if (w >= WAIT_OBJECT_0 + m)
+        return -1;
+    std::size_t i = idx[w - WAIT_OBJECT_0];
+    rc = proc_wait(ps[i], usage);
+    return int(i);
+ #else
+    for (;;) {
+        bool any = false;
+        for (std::size_t i = 0; i < n; ++i)
+            any |= ps[i].pid > 0;
+        if (!any)
+            return -1;
+        int    st  = 0;
+        rusage ru;
+        pid_t  pid = wait4(-1, &st, 0, &ru);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            if (ps[i].pid == pid) {
+                ps[i].pid = 0;
+                if (usage)
+                    _detail::get_usage(ru, *usage);
+                rc = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+                return int(i);
+            }
+        }
+    }
+ #endif
+}
+
+}   // proc_util
+}   // zatu
+
+#endif  // ZATU_PROC_UTIL_HPP_INCLUDED
@@ -0,0 +1,173 @@
+/**
+ *  @file   watch_util.hpp
+ *  @brief  Wait for changes of a set of files.
+ *  @author Masashi Kitamura (tenka@6809.net)
+ *  @date   2026-10-16
+ *  @license    Boost Software License, Version 1.0
+ *  @note
+ *    A change is a new size or mtime (or the file appearing or disappearing).
+ *    Linux: inotify on the directories of the files wakes the wait up; others poll.
+ *    Either way the files are compared with their stamps, so events of other files
+ *    in the same directories (e.g. the .obj being written) are ignored.
+ *
+ *  ex)
+ *    watch_util::watcher w;
+ *    w.set_files(paths);
+ *    for (;;) { w.wait(changed); rebuild(changed); }
+ */
+#ifndef ZATU_WATCH_UTIL_HPP_INCLUDED
+#define ZATU_WATCH_UTIL_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "file_util.hpp"
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+#endif
+
+namespace zatu {
+namespace watch_util {
+
+class watcher {
+public:
+    /// quiet_ms: changes are gathered until none for this long. poll_ms: interval without inotify.
+    explicit watcher(unsigned quiet_ms = 100, unsigned poll_ms = 500)
+        : quiet_ms_(quiet_ms), poll_ms_(poll_ms), fd_(-1)
+    {
+     #if defined(__linux__)
+        fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+     #endif
+    }
+
+    ~watcher() {
+     #if !defined(_WIN32)
+        if (fd_ != -1)
+            close(fd_);
+     #endif
+    }
+
+    /// true if inotify is used.
+    bool notified() const { return fd_ != -1; }
+
+    /// Watch paths instead of the current set. Their present state is the base.
+    void set_files(std::vector<std::string> const& paths) {
+        stamp_map old;
+        old.swap(stamps_);
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            stamp_map::iterator it = old.find(paths[i]);
+            stamps_[paths[i]] = (it != old.end()) ? it->second : stamp(paths[i]);
+         #if defined(__linux__)
+            std::string dir = paths[i].substr(0, paths[i].find_last_of('/') + 1);
+            if (dir.empty())
+                dir = ".";
+            if (fd_ != -1 && dirs_.insert(dir).second)
+                inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB);
+         #endif
+        }
+    }
+
+    /// Wait until files change, then for them to settle. changed receives the changed files.
+    void wait(std::vector<std::string>& changed) {
+        std::set<std::string> s;
+        while (s.empty()) {
+            wake(poll_ms_);
+            diff(s);
+        }
+        do {
+            sleep_ms(quiet_ms_);
+            drain();
+        } while (diff(s));
+        changed.assign(s.begin(), s.end());
+    }
+
+private:
+    struct stamp_t {
+        unsigned long long  size;
+        unsigned long long  mtime;
+        bool                exists;
+        bool operator!=(stamp_t const& r) const { return size != r.size || mtime != r.mtime || exists != r.exists; }
+    };
+    typedef std::map<std::string, stamp_t>  stamp_map;
+
+    static stamp_t stamp(std::string const& path) {
+        file_util::file_stat_t st;
+        stamp_t                t;
+        t.exists = file_util::file_stat(path.c_str(), st);
+        t.size   = st.size;
+        t.mtime  = st.mtime;
+        return t;
+    }
+
+    /// Add the files changed since the last call to s. @return number of them.
+    std::size_t diff(std::set<std::string>& s) {
+        std::size_t n = 0;
+        for (stamp_map::iterator it = stamps_.begin(); it != stamps_.end(); ++it) {
+            stamp_t t = stamp(it->first);
+            if (t != it->second) {
+                it->second = t;
+                s.insert(it->first);
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    /// Wait for an inotify event, or ms without inotify.
+    void wake(unsigned ms) {
+     #if defined(__linux__)
+        if (fd_ != -1) {
+            pollfd p;
+            p.fd      = fd_;
+            p.events  = POLLIN;
+            p.revents = 0;
+            ::poll(&p, 1, int(ms) * 10);   // slowly polls files whose directory is not watched.
+            drain();
+            return;
+        }
+     #endif
+        sleep_ms(ms);
+    }
+
+    void drain() {
+     #if defined(__linux__)
+        char buf[4096];
+        while (fd_ != -1 && ::read(fd_, buf, sizeof buf) > 0)
+            ;
+     #endif
+    }
+
+    static void sleep_ms(unsigned ms) {
+     #if defined(_WIN32)
+        Sleep(ms);
+     #else
+        ::poll(NULL, 0, int(ms));
+     #endif
+    }
+
+private:
+    unsigned                quiet_ms_;
+    unsigned                poll_ms_;
+    int                     fd_;
+    stamp_map               stamps_;
+    std::set<std::string>   dirs_;      // watched by inotify.
+};
+
+}   // namespace watch_util
+}   // namespace zatu
+
+#endif  // ZATU_WATCH_UTIL_HPP_INCLUDED